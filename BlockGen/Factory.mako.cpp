@@ -71,6 +71,7 @@ static const std::vector<Pothos::BlockRegistry> BlockRegistries =
                 ${"true" if block["supportedTypes"].get("supportComplexFloat", block["supportedTypes"].get("supportAll", False)) else "false"},
             }, 4)
             .bind<bool>(${"true" if block.get("postBuffer", True) else "false"}, 5)
+            .bind<bool>(${"true" if block.get("associative", False) else "false"}, 6)
     ),
 %endfor
 };
@@ -1,9 +1,12 @@
-// Copyright (c) 2019-2021 Nicholas Corgan
+// Copyright (c) 2019-2021,2023 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include "ArrayFireBlock.hpp"
+#include "ArrayFireContext.hpp"
 #include "BufferConversions.hpp"
+#include "DeviceBuffer.hpp"
 #include "DeviceCache.hpp"
+#include "DeviceProfile.hpp"
 #include "SharedBufferAllocator.hpp"
 #include "Utility.hpp"
 
@@ -19,12 +22,16 @@
 #include <arrayfire.h>
 
 #include <algorithm>
+#include <cstring>
 #include <string>
 
 #ifdef POTHOSGPU_LEGACY_BUFFER_MANAGER
 Pothos::BufferManager::Sptr makePinnedBufferManager(af::Backend backend);
 #endif
 
+// Only applies when batching is enabled.
+static constexpr double DefaultMaxBatchLatency = 0.01;
+
 static void checkVersion()
 {
     static constexpr size_t buildAPIVersion = AF_API_VERSION_CURRENT;
@@ -47,9 +54,19 @@ static void checkVersion()
     }
 }
 
-ArrayFireBlock::ArrayFireBlock(const std::string& device):
+ArrayFireBlock::ArrayFireBlock(
+    const std::string& device,
+    DeviceOpClass autoOpClass
+):
     Pothos::Block(),
-    _afDeviceName(device)
+    _afDeviceName(device),
+    _profilingEnabled(false),
+    _computeTime(0.0),
+    _minBatchElements(0),
+    _maxBatchLatency(DefaultMaxBatchLatency),
+    _numBatchedElements(0),
+    _pipelineDepth(0),
+    _fusionEnabled(true)
 {
     checkVersion();
 
@@ -59,35 +76,29 @@ ArrayFireBlock::ArrayFireBlock(const std::string& device):
         throw Pothos::RuntimeException("No ArrayFire devices found. Check your ArrayFire installation.");
     }
 
-    if(device == "Auto")
+    const auto deviceToFind = (device == "Auto") ? getAutoDevice(autoOpClass)
+                                                 : device;
+
+    auto deviceCacheIter = std::find_if(
+                               deviceCache.begin(),
+                               deviceCache.end(),
+                               [&deviceToFind](const DeviceCacheEntry& entry)
+                               {
+                                   return (entry.name == deviceToFind) ||
+                                          (Poco::format("%s:%d", entry.platform, entry.afDeviceIndex) == deviceToFind);
+                               });
+    if(deviceCache.end() != deviceCacheIter)
     {
-        _afBackend = deviceCache[0].afBackendEnum;
-        _afDevice = deviceCache[0].afDeviceIndex;
-        _afDeviceName = deviceCache[0].name;
+        _afBackend = deviceCacheIter->afBackendEnum;
+        _afDevice = deviceCacheIter->afDeviceIndex;
+        _afDeviceName = deviceCacheIter->name;
     }
     else
     {
-        auto deviceCacheIter = std::find_if(
-                                   deviceCache.begin(),
-                                   deviceCache.end(),
-                                   [&device](const DeviceCacheEntry& entry)
-                                   {
-                                       return (entry.name == device) ||
-                                              (Poco::format("%s:%d", entry.platform, entry.afDeviceIndex) == device);
-                                   });
-        if(deviceCache.end() != deviceCacheIter)
-        {
-            _afBackend = deviceCacheIter->afBackendEnum;
-            _afDevice = deviceCacheIter->afDeviceIndex;
-            _afDeviceName = deviceCacheIter->name;
-        }
-        else
-        {
-            throw Pothos::InvalidArgumentException(
-                      Poco::format(
-                          "Could not find ArrayFire device %s.",
-                          device));
-        }
+        throw Pothos::InvalidArgumentException(
+                  Poco::format(
+                      "Could not find ArrayFire device %s.",
+                      device));
     }
 
     _domain = "ArrayFire_" + this->backend();
@@ -96,6 +107,14 @@ ArrayFireBlock::ArrayFireBlock(const std::string& device):
     this->registerCall(this, POTHOS_FCN_TUPLE(ArrayFireBlock, backend));
     this->registerCall(this, POTHOS_FCN_TUPLE(ArrayFireBlock, device));
     this->registerCall(this, POTHOS_FCN_TUPLE(ArrayFireBlock, overlay));
+    this->registerCall(this, POTHOS_FCN_TUPLE(ArrayFireBlock, profilingEnabled));
+    this->registerCall(this, POTHOS_FCN_TUPLE(ArrayFireBlock, setProfilingEnabled));
+    this->registerCall(this, POTHOS_FCN_TUPLE(ArrayFireBlock, transferStats));
+    this->registerCall(this, POTHOS_FCN_TUPLE(ArrayFireBlock, resetTransferStats));
+    this->registerCall(this, POTHOS_FCN_TUPLE(ArrayFireBlock, fusionEnabled));
+    this->registerCall(this, POTHOS_FCN_TUPLE(ArrayFireBlock, setFusionEnabled));
+
+    this->registerProbe("transferStats");
 }
 
 ArrayFireBlock::~ArrayFireBlock()
@@ -106,37 +125,46 @@ Pothos::BufferManager::Sptr ArrayFireBlock::getInputBufferManager(
     const std::string& /*name*/,
     const std::string& domain)
 {
-    if(domain.empty())
-    {
-        Pothos::BufferManager::Sptr bufferManager;
-#ifdef POTHOSGPU_LEGACY_BUFFER_MANAGER
-        bufferManager = makePinnedBufferManager(_afBackend);
-#else
-        bufferManager = Pothos::BufferManager::make("generic");
-        bufferManager->setAllocateFunction(getSharedBufferAllocator(_afBackend));
-#endif
-        return bufferManager;
-    }
+    if(domain.empty()) return this->_makeHostBufferManager();
     else if(domain == _domain) return Pothos::BufferManager::Sptr();
     else throw Pothos::PortDomainError(domain);
 }
 
 Pothos::BufferManager::Sptr ArrayFireBlock::getOutputBufferManager(
-    const std::string& /*name*/,
+    const std::string& name,
     const std::string& domain)
 {
-    if(domain.empty() || (domain == _domain))
-    {
-        Pothos::BufferManager::Sptr bufferManager;
+    // If all consumers are in our domain, they can accept af::array handles
+    // directly, so skip the device-to-host copy. The buffer manager is still
+    // needed for blocks that write to the output buffer directly.
+    if(domain == _domain) _deviceResidentOutputs.insert(name);
+    else                  _deviceResidentOutputs.erase(name);
+
+    if(domain.empty() || (domain == _domain)) return this->_makeHostBufferManager();
+    else throw Pothos::PortDomainError(domain);
+}
+
+Pothos::BufferManager::Sptr ArrayFireBlock::_makeHostBufferManager() const
+{
+    Pothos::BufferManager::Sptr bufferManager;
 #ifdef POTHOSGPU_LEGACY_BUFFER_MANAGER
-        bufferManager = makePinnedBufferManager(_afBackend);
+    bufferManager = makePinnedBufferManager(_afBackend);
 #else
+    // On the CPU backend, there are no device transfers for ArrayFire's
+    // pinned memory to speed up, so use Pothos's double-mapped ring, which
+    // never splits chunks at a wrap boundary. Pinned memory can't be mapped
+    // twice, so the GPU backends keep separate pooled pinned buffers.
+    if(::AF_BACKEND_CPU == _afBackend)
+    {
+        bufferManager = Pothos::BufferManager::make("circular");
+    }
+    else
+    {
         bufferManager = Pothos::BufferManager::make("generic");
         bufferManager->setAllocateFunction(getSharedBufferAllocator(_afBackend));
-#endif
-        return bufferManager;
     }
-    else throw Pothos::PortDomainError(domain);
+#endif
+    return bufferManager;
 }
 
 void ArrayFireBlock::activate()
@@ -144,6 +172,16 @@ void ArrayFireBlock::activate()
     this->configArrayFire();
 }
 
+void ArrayFireBlock::deactivate()
+{
+    this->configArrayFire();
+    this->flushPipelinedOutputs();
+
+    // Anything that didn't fit can't be produced now.
+    _pipelinedOutputs.clear();
+    this->_clearBatches();
+}
+
 std::string ArrayFireBlock::backend() const
 {
     return Pothos::Object(_afBackend).convert<std::string>();
@@ -186,10 +224,142 @@ std::string ArrayFireBlock::overlay() const
     return topObj.dump();
 }
 
+size_t ArrayFireBlock::pipelineDepth() const
+{
+    return _pipelineDepth;
+}
+
+void ArrayFireBlock::setPipelineDepth(size_t pipelineDepth)
+{
+    _pipelineDepth = pipelineDepth;
+}
+
+size_t ArrayFireBlock::minBatchElements() const
+{
+    return _minBatchElements;
+}
+
+void ArrayFireBlock::setMinBatchElements(size_t minBatchElements)
+{
+    _minBatchElements = minBatchElements;
+}
+
+double ArrayFireBlock::maxBatchLatency() const
+{
+    return _maxBatchLatency.count();
+}
+
+void ArrayFireBlock::setMaxBatchLatency(double maxBatchLatency)
+{
+    if(maxBatchLatency < 0.0)
+    {
+        throw Pothos::RangeException("Latency cannot be negative.");
+    }
+
+    _maxBatchLatency = std::chrono::duration<double>(maxBatchLatency);
+}
+
+bool ArrayFireBlock::profilingEnabled() const
+{
+    return _profilingEnabled;
+}
+
+void ArrayFireBlock::setProfilingEnabled(bool profilingEnabled)
+{
+    _profilingEnabled = profilingEnabled;
+}
+
+std::string ArrayFireBlock::transferStats() const
+{
+    auto transferStatsToJSON = [](const TransferStats& stats)
+    {
+        nlohmann::json statsObj;
+        statsObj["Bytes"] = stats.bytes;
+        statsObj["Transfers"] = stats.count;
+        statsObj["Time (s)"] = stats.time.count();
+
+        return statsObj;
+    };
+
+    nlohmann::json topObj;
+    topObj["Profiling Enabled"] = _profilingEnabled;
+    topObj["Host to Device"] = transferStatsToJSON(_hostToDeviceStats);
+    topObj["Device to Host"] = transferStatsToJSON(_deviceToHostStats);
+    topObj["Compute Time (s)"] = _computeTime.count();
+
+    return topObj.dump();
+}
+
+void ArrayFireBlock::resetTransferStats()
+{
+    _hostToDeviceStats = TransferStats();
+    _deviceToHostStats = TransferStats();
+    _computeTime = std::chrono::duration<double>(0.0);
+}
+
+bool ArrayFireBlock::fusionEnabled() const
+{
+    return _fusionEnabled;
+}
+
+void ArrayFireBlock::setFusionEnabled(bool fusionEnabled)
+{
+    _fusionEnabled = fusionEnabled;
+}
+
 //
 // Input port API
 //
 
+size_t ArrayFireBlock::getBatchElements(size_t elems)
+{
+    if(0 == _minBatchElements) return elems;
+
+    // Stage whatever is available on all inputs, regardless of output space.
+    const size_t inputElems = this->workInfo().minAllInElements;
+    if(inputElems > 0)
+    {
+        if(0 == _numBatchedElements)
+        {
+            _batchStartTime = std::chrono::steady_clock::now();
+        }
+
+        for(auto* inputPort: this->inputs())
+        {
+            auto bufferChunk = inputPort->buffer();
+            bufferChunk.length = inputElems * bufferChunk.dtype.size();
+            inputPort->consume(inputElems);
+
+            _batchedInputs[inputPort->name()].emplace_back(this->uploadBufferChunk(bufferChunk));
+        }
+
+        _numBatchedElements += inputElems;
+    }
+
+    if(0 == _numBatchedElements) return 0;
+
+    const bool isBatchFull = (_numBatchedElements >= _minBatchElements);
+    const bool isLatencyExceeded = (std::chrono::steady_clock::now() - _batchStartTime) >= _maxBatchLatency;
+    if(!isBatchFull && !isLatencyExceeded)
+    {
+        // No new input may arrive, so make sure we're called again to
+        // check the latency bound.
+        this->yield();
+        return 0;
+    }
+
+    for(auto& batchedInputsPair: _batchedInputs)
+    {
+        _readyBatches[batchedInputsPair.first] = joinAfArrays(0, batchedInputsPair.second);
+        batchedInputsPair.second.clear();
+    }
+
+    const size_t batchElems = _numBatchedElements;
+    _numBatchedElements = 0;
+
+    return batchElems;
+}
+
 af::array ArrayFireBlock::getInputPortAsAfArray(
     size_t portNum,
     bool truncateToMinLength)
@@ -204,6 +374,13 @@ af::array ArrayFireBlock::getInputPortAsAfArray(
     return _getInputPortAsAfArray(portName, truncateToMinLength);
 }
 
+af::array ArrayFireBlock::consumeInputPortAsAfArray(
+    size_t portNum,
+    size_t numElements)
+{
+    return _consumeInputPortAsAfArray(portNum, numElements);
+}
+
 //
 // Output port API
 //
@@ -236,22 +413,337 @@ void ArrayFireBlock::postAfArray(
     _postAfArray(portName, afArray);
 }
 
+void ArrayFireBlock::produceColumnsFromAfArray(const af::array& afArray)
+{
+    const auto numRows = static_cast<size_t>(afArray.dims(0));
+    const auto numColumns = static_cast<size_t>(afArray.dims(1));
+    if(numColumns > this->outputs().size())
+    {
+        throw Pothos::AssertionViolationException(
+                  "Attempted to output more columns than there are output ports.",
+                  Poco::format(
+                      "Columns: %s, ports: %s",
+                      Poco::NumberFormatter::format(numColumns),
+                      Poco::NumberFormatter::format(this->outputs().size())));
+    }
+
+    // Anything that needs a per-port path (device-resident, pipelined, or
+    // oversized outputs) produces each column separately.
+    bool downloadOnce = (0 == _pipelineDepth) && (numRows > 0);
+    for(size_t col = 0; downloadOnce && (col < numColumns); ++col)
+    {
+        const auto* outputPort = this->output(col);
+        auto pipelinedOutputsIter = _pipelinedOutputs.find(outputPort->name());
+
+        downloadOnce = !_isDeviceResidentOutput(outputPort) &&
+                       (outputPort->elements() >= numRows) &&
+                       ((_pipelinedOutputs.end() == pipelinedOutputsIter) || pipelinedOutputsIter->second.empty());
+    }
+
+    if(!downloadOnce)
+    {
+        for(size_t col = 0; col < numColumns; ++col)
+        {
+            _produceFromAfArray(col, afArray.col(static_cast<int>(col)));
+        }
+        return;
+    }
+
+    // ArrayFire is column-major, so each column is contiguous.
+    const size_t columnBytes = afArray.bytes() / numColumns;
+    if(_columnStagingBuffer.getLength() < afArray.bytes())
+    {
+        _columnStagingBuffer = allocateSharedBuffer(_afBackend, afArray.bytes());
+    }
+
+    auto* columnStagingBuffer = reinterpret_cast<unsigned char*>(_columnStagingBuffer.getAddress());
+    this->_downloadAfArray(afArray, columnStagingBuffer);
+
+    for(size_t col = 0; col < numColumns; ++col)
+    {
+        auto* outputPort = this->output(col);
+
+        std::memcpy(
+            outputPort->buffer().as<void*>(),
+            columnStagingBuffer + (col * columnBytes),
+            columnBytes);
+        outputPort->produce(numRows);
+    }
+}
+
+void ArrayFireBlock::flushPipelinedOutputs()
+{
+    for(auto* outputPort: this->outputs())
+    {
+        _producePipelinedOutputs(outputPort, 0);
+    }
+}
+
+void ArrayFireBlock::registerPipeliningCalls()
+{
+    this->registerCall(this, POTHOS_FCN_TUPLE(ArrayFireBlock, pipelineDepth));
+    this->registerCall(this, POTHOS_FCN_TUPLE(ArrayFireBlock, setPipelineDepth));
+}
+
+void ArrayFireBlock::registerBatchingCalls()
+{
+    this->registerCall(this, POTHOS_FCN_TUPLE(ArrayFireBlock, minBatchElements));
+    this->registerCall(this, POTHOS_FCN_TUPLE(ArrayFireBlock, setMinBatchElements));
+    this->registerCall(this, POTHOS_FCN_TUPLE(ArrayFireBlock, maxBatchLatency));
+    this->registerCall(this, POTHOS_FCN_TUPLE(ArrayFireBlock, setMaxBatchLatency));
+}
+
+//
+// Profiling
+//
+
+using ProfilingClock = std::chrono::steady_clock;
+
+af::array ArrayFireBlock::uploadBufferChunk(const Pothos::BufferChunk& bufferChunk)
+{
+    if(!_profilingEnabled || isDeviceBufferChunk(bufferChunk))
+    {
+        return Pothos::Object(bufferChunk).convert<af::array>();
+    }
+
+    // Don't count anything already queued against this transfer.
+    af::sync();
+
+    const auto startTime = ProfilingClock::now();
+    auto afArray = Pothos::Object(bufferChunk).convert<af::array>();
+    af::sync();
+
+    _hostToDeviceStats.time += (ProfilingClock::now() - startTime);
+    _hostToDeviceStats.bytes += bufferChunk.length;
+    ++_hostToDeviceStats.count;
+
+    return afArray;
+}
+
+template <typename TransferFcn>
+void ArrayFireBlock::_download(
+    const af::array& afArray,
+    const TransferFcn& transferFcn)
+{
+    if(!_profilingEnabled)
+    {
+        transferFcn();
+        return;
+    }
+
+    // ArrayFire evaluates lazily, so the time to evaluate the output, plus
+    // anything still queued, is the block's compute time.
+    const auto computeStartTime = ProfilingClock::now();
+    afArray.eval();
+    af::sync();
+    _computeTime += (ProfilingClock::now() - computeStartTime);
+
+    const auto transferStartTime = ProfilingClock::now();
+    transferFcn();
+
+    _deviceToHostStats.time += (ProfilingClock::now() - transferStartTime);
+    _deviceToHostStats.bytes += afArray.bytes();
+    ++_deviceToHostStats.count;
+}
+
+void ArrayFireBlock::_downloadAfArray(const af::array& afArray, void* hostBuffer)
+{
+    this->_download(afArray, [&](){afArray.host(hostBuffer);});
+}
+
+Pothos::BufferChunk ArrayFireBlock::_downloadAfArrayToBufferChunk(const af::array& afArray)
+{
+    Pothos::BufferChunk bufferChunk;
+    this->_download(afArray, [&](){bufferChunk = Pothos::Object(afArray).convert<Pothos::BufferChunk>();});
+
+    return bufferChunk;
+}
+
 //
 // Misc
 //
 
 void ArrayFireBlock::configArrayFire() const
 {
-    if(af::getActiveBackend() != _afBackend)
+    setThreadArrayFireContext(_afBackend, _afDevice);
+}
+
+void ArrayFireBlock::_clearBatches()
+{
+    _batchedInputs.clear();
+    _readyBatches.clear();
+    _numBatchedElements = 0;
+}
+
+bool ArrayFireBlock::canProcessOnHost() const
+{
+    if((_minBatchElements > 0) || !_deviceResidentOutputs.empty()) return false;
+
+    for(const auto& pipelinedOutputs: _pipelinedOutputs)
+    {
+        if(!pipelinedOutputs.second.empty()) return false;
+    }
+    for(const auto* inputPort: this->inputs())
     {
-        af::setBackend(_afBackend);
+        if(isDeviceBufferChunk(inputPort->buffer())) return false;
+    }
+
+    return true;
+}
+
+bool ArrayFireBlock::_isDeviceResidentOutput(const Pothos::OutputPort* outputPort) const
+{
+    return (_deviceResidentOutputs.count(outputPort->name()) > 0);
+}
+
+void ArrayFireBlock::_producePipelinedOutputs(
+    Pothos::OutputPort* outputPort,
+    size_t numToKeepInFlight)
+{
+    auto pipelinedOutputsIter = _pipelinedOutputs.find(outputPort->name());
+    if(_pipelinedOutputs.end() == pipelinedOutputsIter) return;
+
+    // The output buffer doesn't advance until work() returns, so track how
+    // much we've produced in this call.
+    auto& pipelinedOutputs = pipelinedOutputsIter->second;
+    auto* outputBuffer = outputPort->buffer().as<unsigned char*>();
+    const size_t elemSize = outputPort->dtype().size();
+    size_t elemsAvailable = outputPort->elements();
+
+    while(pipelinedOutputs.size() > numToKeepInFlight)
+    {
+        const auto& afArray = pipelinedOutputs.front();
+        const auto elems = static_cast<size_t>(afArray.elements());
+        if(elems > elemsAvailable)
+        {
+            // Batches may never fit, so allocate a buffer for them, but don't
+            // mix posted buffers with ones produced in this call.
+            if((0 == _minBatchElements) || (elemsAvailable != outputPort->elements())) break;
+
+            outputPort->postBuffer(this->_downloadAfArrayToBufferChunk(afArray));
+            pipelinedOutputs.pop_front();
+            continue;
+        }
+
+        this->_downloadAfArray(afArray, outputBuffer);
+        outputPort->produce(elems);
+
+        outputBuffer += (elems * elemSize);
+        elemsAvailable -= elems;
+        pipelinedOutputs.pop_front();
     }
-    if(af::getDevice() != _afDevice)
+}
+
+#if AF_API_VERSION >= 37
+
+static void checkAfError(af_err err)
+{
+    if(AF_SUCCESS != err)
     {
-        af::setDevice(_afDevice);
+        throw Pothos::RuntimeException(::af_err_to_string(err));
     }
 }
 
+// ArrayFire's memory manager keeps an entry for each locked address it's
+// given, even after the array is released. Wrapping base addresses bounds
+// these to the number of buffers upstream allocates, but upstream blocks
+// that post newly allocated buffers would still add one per buffer, so
+// past this many, buffers are copied instead.
+static constexpr size_t MaxWrappedHostBufferAddresses = 64;
+
+af::array ArrayFireBlock::_wrapHostBufferChunk(const Pothos::BufferChunk& bufferChunk)
+{
+    const auto& sharedBuffer = bufferChunk.getBuffer();
+    const size_t baseAddress = sharedBuffer.getAddress();
+    const size_t elemSize = bufferChunk.dtype.size();
+    const size_t offset = bufferChunk.address - baseAddress;
+
+    // Circular buffers are mapped twice back-to-back, so chunks can extend
+    // past the end of the first mapping.
+    const size_t baseLength = (0 != sharedBuffer.getAlias()) ? (2 * sharedBuffer.getLength())
+                                                              : sharedBuffer.getLength();
+    const size_t baseElems = baseLength / elemSize;
+    if((0 != (offset % elemSize)) || ((offset + bufferChunk.length) > (baseElems * elemSize)))
+    {
+        return af::array();
+    }
+
+    auto wrappedIter = _wrappedHostBuffers.find(baseAddress);
+    if((_wrappedHostBuffers.end() != wrappedIter) &&
+       (static_cast<size_t>(wrappedIter->second.afArray.elements()) != baseElems))
+    {
+        // A different buffer at the same address, so wrap it again once
+        // nothing references the old one.
+        return af::array();
+    }
+    if(_wrappedHostBuffers.end() == wrappedIter)
+    {
+        if((0 == _wrappedHostBufferAddresses.count(baseAddress)) &&
+           (_wrappedHostBufferAddresses.size() >= MaxWrappedHostBufferAddresses))
+        {
+            return af::array();
+        }
+
+        const dim_t dims[] = {static_cast<dim_t>(baseElems)};
+        const auto afDType = Pothos::Object(bufferChunk.dtype).convert<af::dtype>();
+
+        af_array afArrayHandle = nullptr;
+        checkAfError(::af_device_array(
+            &afArrayHandle,
+            reinterpret_cast<void*>(baseAddress),
+            1,
+            dims,
+            afDType));
+
+        // ArrayFire takes ownership of device pointers, so lock it to make sure
+        // ArrayFire never frees memory owned by the buffer manager. If this fails,
+        // leak the handle rather than letting it free the buffer.
+        checkAfError(::af_lock_array(afArrayHandle));
+
+        _wrappedHostBufferAddresses.insert(baseAddress);
+        wrappedIter = _wrappedHostBuffers.emplace(baseAddress, WrappedHostBuffer{{}, af::array(afArrayHandle)}).first;
+    }
+
+    auto& wrappedHostBuffer = wrappedIter->second;
+    wrappedHostBuffer.bufferChunks.emplace_back(bufferChunk);
+
+    const auto firstElem = static_cast<double>(offset / elemSize);
+    return wrappedHostBuffer.afArray(af::seq(firstElem, firstElem + bufferChunk.elements() - 1));
+}
+
+void ArrayFireBlock::_releaseUnreferencedHostBuffers()
+{
+    auto isUnreferenced = [](const WrappedHostBuffer& wrappedHostBuffer)
+    {
+        // Slices share the base array's data, and our own handle accounts
+        // for one reference.
+        int refCount = 0;
+        checkAfError(::af_get_data_ref_count(&refCount, wrappedHostBuffer.afArray.get()));
+
+        return (refCount <= 1);
+    };
+
+    bool synced = false;
+    for(auto wrappedIter = _wrappedHostBuffers.begin(); wrappedIter != _wrappedHostBuffers.end();)
+    {
+        if(isUnreferenced(wrappedIter->second))
+        {
+            // Queued kernels don't hold references to their inputs, so make
+            // sure nothing is still reading these buffers.
+            if(!synced)
+            {
+                af::sync();
+                synced = true;
+            }
+
+            wrappedIter = _wrappedHostBuffers.erase(wrappedIter);
+        }
+        else ++wrappedIter;
+    }
+}
+
+#endif
+
 //
 // The protected functions call into these, making the compiler generate the
 // versions of these with those types.
@@ -262,6 +754,16 @@ af::array ArrayFireBlock::_getInputPortAsAfArray(
     const PortIdType& portId,
     bool truncateToMinLength)
 {
+    // If a batch was staged for this port, it was already consumed.
+    auto readyBatchIter = _readyBatches.find(this->input(portId)->name());
+    if(_readyBatches.end() != readyBatchIter)
+    {
+        auto afArray = readyBatchIter->second;
+        _readyBatches.erase(readyBatchIter);
+
+        return afArray;
+    }
+
     auto bufferChunk = this->input(portId)->buffer();
     const size_t minLength = this->workInfo().minAllElements;
     assert(minLength <= bufferChunk.elements());
@@ -272,7 +774,48 @@ af::array ArrayFireBlock::_getInputPortAsAfArray(
     }
 
     this->input(portId)->consume(minLength);
-    return Pothos::Object(bufferChunk).convert<af::array>();
+
+    return this->_inputBufferChunkToAfArray(bufferChunk);
+}
+
+template <typename PortIdType>
+af::array ArrayFireBlock::_consumeInputPortAsAfArray(
+    const PortIdType& portId,
+    size_t numElements)
+{
+    // If a batch was staged for this port, it was already consumed.
+    auto readyBatchIter = _readyBatches.find(this->input(portId)->name());
+    if(_readyBatches.end() != readyBatchIter)
+    {
+        auto afArray = readyBatchIter->second;
+        _readyBatches.erase(readyBatchIter);
+
+        return afArray;
+    }
+
+    auto bufferChunk = this->input(portId)->buffer();
+    assert(numElements <= bufferChunk.elements());
+
+    bufferChunk.length = numElements * bufferChunk.dtype.size();
+    this->input(portId)->consume(numElements);
+
+    return this->_inputBufferChunkToAfArray(bufferChunk);
+}
+
+af::array ArrayFireBlock::_inputBufferChunkToAfArray(const Pothos::BufferChunk& bufferChunk)
+{
+#if AF_API_VERSION >= 37
+    // Check the block's backend, since that's where the array will be created.
+    if((::AF_BACKEND_CPU == _afBackend) && !isDeviceBufferChunk(bufferChunk))
+    {
+        this->_releaseUnreferencedHostBuffers();
+
+        auto afArray = this->_wrapHostBufferChunk(bufferChunk);
+        if(!afArray.isempty()) return afArray;
+    }
+#endif
+
+    return this->uploadBufferChunk(bufferChunk);
 }
 
 template <typename PortIdType, typename AfArrayType>
@@ -281,6 +824,43 @@ void ArrayFireBlock::_produceFromAfArray(
     const AfArrayType& afArray)
 {
     auto* outputPort = this->output(portId);
+    if(_isDeviceResidentOutput(outputPort))
+    {
+        _postAfArray(portId, afArray);
+        return;
+    }
+
+    // Outputs must be produced in order, so once anything is in flight,
+    // everything goes through the queue.
+    auto pipelinedOutputsIter = _pipelinedOutputs.find(outputPort->name());
+    const bool isPipelined = (_pipelineDepth > 0) ||
+                             ((_pipelinedOutputs.end() != pipelinedOutputsIter) && !pipelinedOutputsIter->second.empty());
+    if(isPipelined)
+    {
+        if(afArray.elements() == 0)
+        {
+            throw Pothos::AssertionViolationException(
+                    "Attempted to output an empty af::array,",
+                    "Port: "+Pothos::Object(portId).convert<std::string>());
+        }
+
+        // Start the computation without waiting on it.
+        af::array evaluatedAfArray(afArray);
+        evaluatedAfArray.eval();
+
+        _pipelinedOutputs[outputPort->name()].emplace_back(std::move(evaluatedAfArray));
+        _producePipelinedOutputs(outputPort, _pipelineDepth);
+        return;
+    }
+
+    // Batches can be larger than the output buffer, so allocate a
+    // buffer for them instead.
+    if((_minBatchElements > 0) && (outputPort->elements() < static_cast<size_t>(afArray.elements())))
+    {
+        _postAfArray(portId, afArray);
+        return;
+    }
+
     if(outputPort->elements() < static_cast<size_t>(afArray.elements()))
     {
         throw Pothos::AssertionViolationException(
@@ -297,7 +877,7 @@ void ArrayFireBlock::_produceFromAfArray(
                 "Port: "+Pothos::Object(portId).convert<std::string>());
     }
 
-    afArray.host(outputPort->buffer());
+    this->_downloadAfArray(afArray, outputPort->buffer());
     outputPort->produce(afArray.elements());
 }
 
@@ -312,5 +892,14 @@ void ArrayFireBlock::_postAfArray(
                 "Attempted to output an empty af::array,",
                 "Port: "+Pothos::Object(portId).convert<std::string>());
     }
-    this->output(portId)->postBuffer(Pothos::Object(afArray).convert<Pothos::BufferChunk>());
+
+    auto* outputPort = this->output(portId);
+    if(_isDeviceResidentOutput(outputPort))
+    {
+        outputPort->postBuffer(afArrayToDeviceBufferChunk(afArray, _fusionEnabled));
+    }
+    else
+    {
+        outputPort->postBuffer(this->_downloadAfArrayToBufferChunk(afArray));
+    }
 }
@@ -1,19 +1,28 @@
-// Copyright (c) 2019-2020 Nicholas Corgan
+// Copyright (c) 2019-2020,2023 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
 #pragma once
 
+#include "DeviceProfile.hpp"
+
 #include <Pothos/Framework.hpp>
 
 #include <arrayfire.h>
 
+#include <chrono>
+#include <deque>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 class ArrayFireBlock: public Pothos::Block
 {
     public:
         ArrayFireBlock() = delete;
-        explicit ArrayFireBlock(const std::string& device);
+        explicit ArrayFireBlock(
+            const std::string& device,
+            DeviceOpClass autoOpClass = DeviceOpClass::Elementwise);
 
         virtual ~ArrayFireBlock();
 
@@ -29,16 +38,48 @@ class ArrayFireBlock: public Pothos::Block
 
         void activate() override;
 
+        void deactivate() override;
+
         std::string backend() const;
 
         std::string device() const;
 
         virtual std::string overlay() const;
 
+        size_t pipelineDepth() const;
+
+        void setPipelineDepth(size_t pipelineDepth);
+
+        size_t minBatchElements() const;
+
+        void setMinBatchElements(size_t minBatchElements);
+
+        double maxBatchLatency() const;
+
+        void setMaxBatchLatency(double maxBatchLatency);
+
+        bool profilingEnabled() const;
+
+        void setProfilingEnabled(bool profilingEnabled);
+
+        std::string transferStats() const;
+
+        void resetTransferStats();
+
+        bool fusionEnabled() const;
+
+        void setFusionEnabled(bool fusionEnabled);
+
         //
         // Input port API
         //
 
+        // Returns the number of elements work() should process, given the
+        // number it would process without batching. When batching, this
+        // stages input on the device and returns 0 until a batch is ready,
+        // after which getInputPortAsAfArray() returns the whole batch.
+        size_t getBatchElements(size_t elems);
+
         af::array getInputPortAsAfArray(
             size_t portNum,
             bool truncateToMinLength = true);
@@ -47,6 +88,17 @@ class ArrayFireBlock: public Pothos::Block
             const std::string& portName,
             bool truncateToMinLength = true);
 
+        // Copies a host buffer to the device, counting the transfer when
+        // profiling. Device-resident buffers are returned without a copy.
+        af::array uploadBufferChunk(const Pothos::BufferChunk& bufferChunk);
+
+        // For blocks whose input and output lengths differ. Consumes and
+        // returns exactly the given number of elements, unless a batch is
+        // ready, in which case the whole batch is returned.
+        af::array consumeInputPortAsAfArray(
+            size_t portNum,
+            size_t numElements);
+
         //
         // Output port API
         //
@@ -67,6 +119,30 @@ class ArrayFireBlock: public Pothos::Block
             const std::string& portName,
             const af::array& afArray);
 
+        // Produces column N of the given array on output port N. When every
+        // port takes host buffers with room for a column, the whole array is
+        // downloaded in one transfer instead of one per port.
+        void produceColumnsFromAfArray(const af::array& afArray);
+
+        // When pipelining, produce any outputs still in flight, as space
+        // allows. Call this when there is no new input to process.
+        void flushPipelinedOutputs();
+
+        // Registers pipelineDepth() and setPipelineDepth(). Only blocks whose
+        // work() calls flushPipelinedOutputs() whenever it has no new input
+        // should call this, or outputs stay queued until deactivate().
+        void registerPipeliningCalls();
+
+        // Registers the batch size and latency getters and setters. Only
+        // blocks whose work() gets its element count from getBatchElements()
+        // should call this, or the settings are accepted and ignored.
+        void registerBatchingCalls();
+
+        // Whether work() can skip ArrayFire and process this call's input
+        // directly on the host. This requires host buffers on all ports and
+        // nothing batched or in flight that would be reordered.
+        bool canProcessOnHost() const;
+
         //
         // Misc
         //
@@ -84,11 +160,105 @@ class ArrayFireBlock: public Pothos::Block
 
     private:
 
+        Pothos::BufferManager::Sptr _makeHostBufferManager() const;
+
+        // Only updated when profiling is enabled. Profiling synchronizes the
+        // device around each transfer so computation and transfers can be
+        // timed separately, which defeats any overlap between them.
+        struct TransferStats
+        {
+            size_t bytes = 0;
+            size_t count = 0;
+            std::chrono::duration<double> time{0.0};
+        };
+
+        bool _profilingEnabled;
+        TransferStats _hostToDeviceStats;
+        TransferStats _deviceToHostStats;
+        std::chrono::duration<double> _computeTime;
+
+        void _downloadAfArray(const af::array& afArray, void* hostBuffer);
+
+        Pothos::BufferChunk _downloadAfArrayToBufferChunk(const af::array& afArray);
+
+        template <typename TransferFcn>
+        void _download(
+            const af::array& afArray,
+            const TransferFcn& transferFcn);
+
+        // When non-zero, work() is deferred until this many input elements
+        // are staged on the device, or until the oldest staged input is
+        // older than the latency bound.
+        size_t _minBatchElements;
+        std::chrono::duration<double> _maxBatchLatency;
+        std::chrono::steady_clock::time_point _batchStartTime;
+        size_t _numBatchedElements;
+        std::unordered_map<std::string, std::vector<af::array>> _batchedInputs;
+        std::unordered_map<std::string, af::array> _readyBatches;
+
+        void _clearBatches();
+
+        // Reused by produceColumnsFromAfArray() for each download. This is
+        // pinned on GPU backends so the download can use DMA.
+        Pothos::SharedBuffer _columnStagingBuffer;
+
+        // When non-zero, produceFromAfArray() queues this many evaluated
+        // outputs per port before downloading the oldest, so transfers
+        // overlap with later computation.
+        size_t _pipelineDepth;
+        std::unordered_map<std::string, std::deque<af::array>> _pipelinedOutputs;
+
+        void _producePipelinedOutputs(
+            Pothos::OutputPort* outputPort,
+            size_t numToKeepInFlight);
+
+        // Output ports whose consumers are all ArrayFire blocks in our
+        // domain. These ports post device-resident buffers.
+        std::unordered_set<std::string> _deviceResidentOutputs;
+
+        // When enabled, device-resident outputs are posted unevaluated, so
+        // consecutive blocks' operations are fused into one kernel. Disable
+        // this to evaluate each block's output separately for debugging.
+        bool _fusionEnabled;
+
+        bool _isDeviceResidentOutput(const Pothos::OutputPort* outputPort) const;
+
+#if AF_API_VERSION >= 37
+        // On the CPU backend, host memory is device memory, so input buffers
+        // are wrapped instead of copied. Each SharedBuffer is wrapped once
+        // from its base address, and each chunk is a slice of it. The chunks
+        // are kept alive until ArrayFire no longer references any slice.
+        struct WrappedHostBuffer
+        {
+            std::vector<Pothos::BufferChunk> bufferChunks;
+
+            // Declared last so it's destroyed before the buffers are released.
+            af::array afArray;
+        };
+        std::unordered_map<size_t, WrappedHostBuffer> _wrappedHostBuffers;
+
+        // Every base address ever wrapped, to bound how many ArrayFire keeps
+        // track of.
+        std::unordered_set<size_t> _wrappedHostBufferAddresses;
+
+        // Returns an empty array if the chunk can't be wrapped.
+        af::array _wrapHostBufferChunk(const Pothos::BufferChunk& bufferChunk);
+
+        void _releaseUnreferencedHostBuffers();
+#endif
+
         template <typename PortIdType>
         af::array _getInputPortAsAfArray(
             const PortIdType& portId,
             bool truncateToMinLength);
 
+        template <typename PortIdType>
+        af::array _consumeInputPortAsAfArray(
+            const PortIdType& portId,
+            size_t numElements);
+
+        af::array _inputBufferChunkToAfArray(const Pothos::BufferChunk& bufferChunk);
+
         template <typename PortIdType, typename AfArrayType>
         void _produceFromAfArray(
             const PortIdType& portId,
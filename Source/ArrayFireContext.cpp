@@ -0,0 +1,73 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "ArrayFireContext.hpp"
+
+#include <Pothos/Plugin.hpp>
+
+#include <arrayfire.h>
+
+#include <array>
+#include <atomic>
+
+//
+// ArrayFire keeps a separate active device for each backend, so cache one per
+// backend. The backend enum values are bit flags, the largest being OpenCL.
+//
+
+struct ThreadArrayFireContext
+{
+    ThreadArrayFireContext():
+        backend(::AF_BACKEND_DEFAULT)
+    {
+        devices.fill(-1);
+    }
+
+    af::Backend backend;
+    std::array<int, ::AF_BACKEND_OPENCL+1> devices;
+};
+
+static thread_local ThreadArrayFireContext threadContext;
+
+static std::atomic<size_t> contextSwitchCount(0);
+
+void setThreadArrayFireBackend(af::Backend backend)
+{
+    if(threadContext.backend != backend)
+    {
+        af::setBackend(backend);
+        threadContext.backend = backend;
+        ++contextSwitchCount;
+    }
+}
+
+void setThreadArrayFireContext(af::Backend backend, int device)
+{
+    setThreadArrayFireBackend(backend);
+
+    auto& activeDevice = threadContext.devices[static_cast<size_t>(backend)];
+    if(activeDevice != device)
+    {
+        af::setDevice(device);
+        activeDevice = device;
+        ++contextSwitchCount;
+    }
+}
+
+size_t getArrayFireContextSwitchCount()
+{
+    return contextSwitchCount.load();
+}
+
+void resetArrayFireContextSwitchCount()
+{
+    contextSwitchCount = 0;
+}
+
+pothos_static_block(registerArrayFireContextStats)
+{
+    Pothos::PluginRegistry::addCall(
+        "/gpu/context/switch_count", &getArrayFireContextSwitchCount);
+    Pothos::PluginRegistry::addCall(
+        "/gpu/context/reset_switch_count", &resetArrayFireContextSwitchCount);
+}
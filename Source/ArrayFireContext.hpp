@@ -0,0 +1,27 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <arrayfire.h>
+
+#include <cstddef>
+
+//
+// Per-thread ArrayFire backend/device selection
+//
+// ArrayFire's active backend and device are per-thread, and setting or
+// querying them isn't free. These functions remember what each thread last
+// set and only call into ArrayFire when something actually changes. For this
+// to hold, everything in this module must go through these instead of calling
+// af::setBackend() or af::setDevice() directly.
+//
+
+void setThreadArrayFireBackend(af::Backend backend);
+
+void setThreadArrayFireContext(af::Backend backend, int device);
+
+// Number of real backend or device changes across all threads.
+size_t getArrayFireContextSwitchCount();
+
+void resetArrayFireContextSwitchCount();
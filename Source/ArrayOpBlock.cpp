@@ -26,9 +26,9 @@
     if(opStr == operation) \
         return new ReducedBlock(device, &func, dtype, "int8", numChans);
 
-#define IfOpThenNToOneBlock(op, opStr) \
+#define IfOpThenNToOneBlock(op, opStr, isAssociative) \
     if(opStr == operation) \
-        return new NToOneBlock(device, NToOneLambda(op), dtype, numChans, false);
+        return new NToOneBlock(device, NToOneLambda(op), dtype, numChans, false, isAssociative);
 
 #define IfOpThenTwoToOneBlock(op, opStr) \
     if(opStr == operation) \
@@ -47,10 +47,10 @@ static Pothos::Block* makeArrayArithmetic(
     validateDType(dtype, dtypeSupport);
 
     IfOpThenReducedBlock("Add", af::sum)
-    else IfOpThenNToOneBlock(-, "Subtract")
+    else IfOpThenNToOneBlock(-, "Subtract", false)
     else IfOpThenReducedBlock("Multiply", af::product)
-    else IfOpThenNToOneBlock(/, "Divide")
-    else IfOpThenNToOneBlock(%, "Modulus")
+    else IfOpThenNToOneBlock(/, "Divide", false)
+    else IfOpThenNToOneBlock(%, "Modulus", false)
 
     throw Pothos::InvalidArgumentException("Invalid operation", operation);
 }
@@ -84,9 +84,9 @@ static Pothos::Block* makeArrayBitwise(
 {
     if(isDTypeAnyInt(dtype))
     {
-        IfOpThenNToOneBlock(&, "And")
-        else IfOpThenNToOneBlock(|, "Or")
-        else IfOpThenNToOneBlock(^, "XOr")
+        IfOpThenNToOneBlock(&, "And", true)
+        else IfOpThenNToOneBlock(|, "Or", true)
+        else IfOpThenNToOneBlock(^, "XOr", true)
 
         throw Pothos::InvalidArgumentException("Invalid operation", operation);
     }
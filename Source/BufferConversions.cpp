@@ -1,7 +1,8 @@
-// Copyright (c) 2019-2020 Nicholas Corgan
+// Copyright (c) 2019-2020,2023 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include "BufferConversions.hpp"
+#include "DeviceBuffer.hpp"
 #include "SharedBufferAllocator.hpp"
 #include "Utility.hpp"
 
@@ -39,6 +40,12 @@ Pothos::BufferChunk afArrayTypeToBufferChunk(const AfArrayType& afArray)
 
 static af::array bufferChunkToAfArray(const Pothos::BufferChunk& bufferChunk)
 {
+    // Chunks passed between ArrayFire blocks may already be on the device.
+    if(isDeviceBufferChunk(bufferChunk))
+    {
+        return deviceBufferChunkToAfArray(bufferChunk);
+    }
+
     af::array ret(
         bufferChunk.elements(),
         Pothos::Object(bufferChunk.dtype).convert<af::dtype>());
@@ -1,4 +1,4 @@
-// Copyright (c) 2019-2020 Nicholas Corgan
+// Copyright (c) 2019-2020,2023 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include "OneToOneBlock.hpp"
@@ -56,9 +56,12 @@ class CastBlock: public OneToOneBlock
 
         void work() override
         {
-            const size_t elems = this->workInfo().minElements;
+            this->configArrayFire();
+
+            const size_t elems = this->getBatchElements(this->workInfo().minElements);
             if(0 == elems)
             {
+                this->flushPipelinedOutputs();
                 return;
             }
 
@@ -0,0 +1,377 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "ArrayFireBlock.hpp"
+#include "FFTPlanCache.hpp"
+#include "SignalUtility.hpp"
+#include "Utility.hpp"
+
+#include <Pothos/Exception.hpp>
+#include <Pothos/Framework.hpp>
+#include <Pothos/Object.hpp>
+
+#include <arrayfire.h>
+
+#include <algorithm>
+#include <complex>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+//
+// Channel k is the input shifted down by k/numChannels cycles per sample,
+// low-pass filtered with the prototype taps, and decimated. Splitting the
+// taps into numChannels branches, the shift becomes an inverse DFT across
+// the branches' outputs:
+//
+//   y_k[m] = e^(-j*2*pi*k*m*D/M) * sum_r e^(j*2*pi*k*r/M) * v_r[m]
+//   v_r[m] = sum_q h[r + qM] * x[mD - r - qM]
+//
+// for M channels and a decimation of D. When critically sampled (D = M), the
+// leading phase term is always 1. When 2x oversampled (D = M/2), it's
+// (-1)^(k*m).
+//
+
+template <typename In, typename Out>
+class ChannelizerBlock: public ArrayFireBlock
+{
+    public:
+        using InType = In;
+        using OutType = Out;
+        using Class = ChannelizerBlock<In, Out>;
+        using TapType = typename OutType::value_type;
+
+        static const Pothos::DType inDType;
+
+        ChannelizerBlock(
+            const std::string& device,
+            size_t dtypeDims,
+            size_t numChannels,
+            size_t oversampling
+        ):
+            ArrayFireBlock(device, DeviceOpClass::FFT),
+            _numChannels(numChannels),
+            _oversampling(oversampling),
+            _decimation(0),
+            _numBranchTaps(0),
+            _nextOutputPosition(0),
+            _outputParity(0)
+        {
+            if(0 == _numChannels)
+            {
+                throw Pothos::InvalidArgumentException("numChannels must be > 0.");
+            }
+            if((1 != _oversampling) && (2 != _oversampling))
+            {
+                throw Pothos::InvalidArgumentException("oversampling must be 1 or 2.");
+            }
+            if(0 != (_numChannels % _oversampling))
+            {
+                throw Pothos::InvalidArgumentException("For 2x oversampling, numChannels must be even.");
+            }
+            _decimation = _numChannels / _oversampling;
+
+            static const Pothos::DType outDType(typeid(OutType));
+
+            this->setupInput(0, Pothos::DType::fromDType(inDType, dtypeDims), _domain);
+            for(size_t chan = 0; chan < _numChannels; ++chan)
+            {
+                this->setupOutput(chan, Pothos::DType::fromDType(outDType, dtypeDims), _domain);
+            }
+
+            this->setTaps({});
+
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, numChannels));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, oversampling));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, taps));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, setTaps));
+            this->registerPipeliningCalls();
+            this->registerBatchingCalls();
+        }
+
+        virtual ~ChannelizerBlock() = default;
+
+        void activate() override
+        {
+            ArrayFireBlock::activate();
+
+            this->_resetState();
+
+            // The batch size is the number of outputs, which depends on
+            // the input.
+            _planReservation.reserve(
+                _afBackend,
+                _afDevice,
+                {getC2CFFTPlanKey(Pothos::Object(Class::inDType).convert<af::dtype>(), _numChannels, 0)});
+        }
+
+        void deactivate() override
+        {
+            ArrayFireBlock::deactivate();
+
+            _planReservation.release();
+        }
+
+        size_t numChannels() const
+        {
+            return _numChannels;
+        }
+
+        size_t oversampling() const
+        {
+            return _oversampling;
+        }
+
+        std::vector<TapType> taps() const
+        {
+            return _taps;
+        }
+
+        // If empty, a boxcar of numChannels taps is used, which makes this
+        // a sliding DFT.
+        void setTaps(const std::vector<TapType>& taps)
+        {
+            this->configArrayFire();
+
+            _taps = taps.empty() ? std::vector<TapType>(_numChannels, TapType(1.0)) : taps;
+
+            // Pad the taps to a whole number of branch taps, so each output's
+            // samples can be multiplied by them as one column.
+            const size_t numBranchTaps = (_taps.size() + _numChannels - 1) / _numChannels;
+            auto paddedTaps = _taps;
+            paddedTaps.resize(numBranchTaps * _numChannels, TapType(0));
+
+            _afTaps = Pothos::Object(paddedTaps).convert<af::array>();
+
+            if(numBranchTaps != _numBranchTaps)
+            {
+                _numBranchTaps = numBranchTaps;
+                this->_resetHistory();
+            }
+        }
+
+        void work() override
+        {
+            // The thread may have changed since the block was created, so make sure
+            // the backend and device still match.
+            this->configArrayFire();
+
+            // Only take as much input as there's room to output on every channel.
+            size_t maxOutputs = this->output(0)->elements();
+            for(const auto* outputPort: this->outputs())
+            {
+                maxOutputs = std::min(maxOutputs, outputPort->elements());
+            }
+            const size_t maxInputs = _nextOutputPosition + (maxOutputs * _decimation);
+
+            const size_t elems = this->getBatchElements(std::min(this->input(0)->elements(), maxInputs));
+            if(0 == elems)
+            {
+                this->flushPipelinedOutputs();
+                return;
+            }
+
+            auto afInput = this->consumeInputPortAsAfArray(0, elems);
+            const size_t numInputs = afInput.elements();
+
+            auto afSignal = _afHistory.isempty() ? afInput : af::join(0, _afHistory, afInput);
+
+            if(_nextOutputPosition < numInputs)
+            {
+                const size_t numOutputs = (numInputs - _nextOutputPosition + _decimation - 1) / _decimation;
+
+                // Transposed, so each channel's outputs are one column.
+                this->produceColumnsFromAfArray(af::transpose(this->_channelize(afSignal, numOutputs)));
+
+                _nextOutputPosition += (numOutputs * _decimation);
+                _outputParity = (_outputParity + numOutputs) % 2;
+            }
+            _nextOutputPosition -= numInputs;
+
+            if(!_afHistory.isempty())
+            {
+                const size_t signalLength = afSignal.elements();
+                const size_t numHistory = _afHistory.elements();
+
+                _afHistory = afSignal(af::seq(
+                                 static_cast<double>(signalLength - numHistory),
+                                 static_cast<double>(signalLength - 1)));
+                _afHistory.eval();
+            }
+        }
+
+    private:
+        size_t _numChannels;
+        size_t _oversampling;
+        size_t _decimation;
+
+        std::vector<TapType> _taps;
+        size_t _numBranchTaps;
+        af::array _afTaps;
+
+        // The last (numTaps-1) input samples, kept on the device.
+        af::array _afHistory;
+
+        // Where the next output's newest sample falls, relative to the first
+        // sample of the next input chunk.
+        size_t _nextOutputPosition;
+
+        // Whether the next output's index is odd, for the oversampled phase
+        size_t _outputParity;
+
+        FFTPlanReservation _planReservation;
+
+        void _resetHistory()
+        {
+            const size_t numHistory = (_numBranchTaps * _numChannels) - 1;
+            if(numHistory > 0)
+            {
+                _afHistory = af::constant(
+                                 0,
+                                 static_cast<dim_t>(numHistory),
+                                 Pothos::Object(Class::inDType).convert<af::dtype>());
+            }
+            else _afHistory = af::array();
+        }
+
+        void _resetState()
+        {
+            this->_resetHistory();
+            _nextOutputPosition = 0;
+            _outputParity = 0;
+        }
+
+        // Returns a numChannels x numOutputs array.
+        af::array _channelize(const af::array& afSignal, size_t numOutputs)
+        {
+            const size_t numTaps = _numBranchTaps * _numChannels;
+            const auto numChannelsDim = static_cast<dim_t>(_numChannels);
+            const auto numBranchTapsDim = static_cast<dim_t>(_numBranchTaps);
+            const auto numOutputsDim = static_cast<dim_t>(numOutputs);
+
+            // Each output's samples, newest first, so row l is x[mD - l]. The
+            // first output's newest sample follows the history.
+            auto afFrames = af::flip(
+                                getOverlappedFrames(
+                                    afSignal(af::seq(static_cast<double>(_nextOutputPosition), af::end)),
+                                    numTaps,
+                                    _decimation,
+                                    numOutputs),
+                                0);
+
+            // Split each column into numChannels branches and run every
+            // branch's FIR for every output at once.
+            auto afProducts = afFrames * af::tile(_afTaps, 1, static_cast<unsigned>(numOutputs));
+            auto afBranches = af::moddims(
+                                  af::sum(af::moddims(afProducts, numChannelsDim, numBranchTapsDim, numOutputsDim), 1),
+                                  numChannelsDim,
+                                  numOutputsDim);
+
+            // Unnormalized, since the shift is a sum over the branches.
+            auto afChannels = af::ifftNorm(
+                                  IsComplex<InType>::value ? afBranches : af::complex(afBranches),
+                                  1.0);
+
+            if(2 == _oversampling)
+            {
+                // (-1)^(k*m), with m's parity tracked across calls
+                auto afChannelIndices = af::range(af::dim4(numChannelsDim, numOutputsDim), 0, ::u32);
+                auto afOutputIndices = af::range(af::dim4(numChannelsDim, numOutputsDim), 1, ::u32)
+                                     + static_cast<unsigned>(_outputParity);
+                static const auto afSignDType = Pothos::Object(Pothos::DType(typeid(TapType))).convert<af::dtype>();
+                auto afSigns = 1.0 - (2.0 * ((afChannelIndices * afOutputIndices) % 2).as(afSignDType));
+
+                afChannels = afChannels * afSigns;
+            }
+
+            return afChannels;
+        }
+};
+
+template <typename In, typename Out>
+const Pothos::DType ChannelizerBlock<In, Out>::inDType(typeid(In));
+
+//
+// Factory
+//
+
+static Pothos::Block* makeChannelizer(
+    const std::string& device,
+    const Pothos::DType& dtype,
+    size_t numChannels,
+    size_t oversampling)
+{
+    #define __ifTypeDeclareFactory(InType, FloatType) \
+        if(Pothos::DType::fromDType(dtype, 1) == Pothos::DType(typeid(InType))) \
+            return new ChannelizerBlock<InType, std::complex<FloatType>>(device, dtype.dimension(), numChannels, oversampling);
+    #define ifTypeDeclareFactory(FloatType) \
+        __ifTypeDeclareFactory(FloatType, FloatType) \
+        __ifTypeDeclareFactory(std::complex<FloatType>, FloatType)
+
+    ifTypeDeclareFactory(float)
+    ifTypeDeclareFactory(double)
+    #undef ifTypeDeclareFactory
+    #undef __ifTypeDeclareFactory
+
+    throw Pothos::InvalidArgumentException(
+              "Unsupported type.",
+              dtype.name());
+}
+
+//
+// Block registries
+//
+
+/*
+ * |PothosDoc Polyphase Channelizer (GPU)
+ *
+ * Splits the input into <b>numChannels</b> equally spaced channels with a
+ * polyphase filterbank, outputting each channel on its own port. Channel k is
+ * centered at k/numChannels cycles per sample, so channels past the halfway
+ * point are negative frequencies.
+ *
+ * Each channel is the input shifted to baseband, low-pass filtered with the
+ * prototype taps, and decimated by <b>numChannels</b> (critically sampled) or
+ * by <b>numChannels/2</b> (2x oversampled). All branch filters run as one
+ * batched operation, followed by one batched FFT across the branches. The
+ * filter's history is kept on the device between calls.
+ *
+ * The taps should be a low-pass filter with a cutoff of about half the channel
+ * spacing, designed at the input rate. They can be set at runtime by connecting
+ * the output of a FIR Designer block to <b>"setTaps"</b>. If no taps are given,
+ * a boxcar of <b>numChannels</b> taps is used, which makes this a sliding DFT.
+ *
+ * |category /GPU/Signal
+ * |category /Filter/GPU
+ * |keywords array tap taps fir polyphase filterbank channelizer pfb fft
+ * |factory /gpu/signal/channelizer(device,dtype,numChannels,oversampling)
+ * |setter setTaps(taps)
+ *
+ * |param device[Device] Device to use for processing.
+ * |default "Auto"
+ *
+ * |param dtype[Data Type] The input's data type. The outputs are complex, with the same precision.
+ * |widget DTypeChooser(float=1,cfloat=1,dim=1)
+ * |default "complex_float32"
+ * |preview disable
+ *
+ * |param numChannels[Num Channels] The number of channels, which is also the number of output ports.
+ * |widget SpinBox(minimum=1)
+ * |default 64
+ * |preview enable
+ *
+ * |param oversampling[Oversampling] How much faster each channel is sampled than the channel spacing.
+ * |widget ComboBox(editable=false)
+ * |option [Critically Sampled] 1
+ * |option [2x Oversampled] 2
+ * |default 1
+ * |preview enable
+ *
+ * |param taps[Taps] The prototype low-pass filter taps. Leave empty for a boxcar.
+ * |widget LineEdit()
+ * |default []
+ * |preview disable
+ */
+static Pothos::BlockRegistry registerChannelizer(
+    "/gpu/signal/channelizer",
+    Pothos::Callable(&makeChannelizer));
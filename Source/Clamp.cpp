@@ -115,9 +115,12 @@ const Pothos::DType Clamp<T>::dtype = Pothos::DType(typeid(T));
 template <typename T>
 void Clamp<T>::work()
 {
-    const auto elems = this->workInfo().minElements;
+    this->configArrayFire();
+
+    const auto elems = this->getBatchElements(this->workInfo().minElements);
     if(0 == elems)
     {
+        this->flushPipelinedOutputs();
         return;
     }
 
@@ -134,9 +137,12 @@ void Clamp<T>::work()
 template <>
 void Clamp<double>::work()
 {
-    const auto elems = this->workInfo().minElements;
+    this->configArrayFire();
+
+    const auto elems = this->getBatchElements(this->workInfo().minElements);
     if(0 == elems)
     {
+        this->flushPipelinedOutputs();
         return;
     }
 
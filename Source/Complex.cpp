@@ -57,6 +57,8 @@ class CombineComplex: public ArrayFireBlock
                 return;
             }
 
+            this->configArrayFire();
+
             auto afReal = this->getInputPortAsAfArray("re");
             auto afImag = this->getInputPortAsAfArray("im");
             
@@ -101,6 +103,8 @@ class SplitComplex: public ArrayFireBlock
                 return;
             }
 
+            this->configArrayFire();
+
             auto afInput = this->getInputPortAsAfArray(0);
             this->produceFromAfArray("re", af::real(afInput));
             this->produceFromAfArray("im", af::imag(afInput));
@@ -144,6 +148,8 @@ class PolarToComplex: public ArrayFireBlock
                 return;
             }
 
+            this->configArrayFire();
+
             auto afMag = this->getInputPortAsAfArray("mag");
             auto afPhase = this->getInputPortAsAfArray("phase");
             
@@ -188,6 +194,8 @@ class ComplexToPolar: public ArrayFireBlock
                 return;
             }
 
+            this->configArrayFire();
+
             auto afInput = this->getInputPortAsAfArray(0);
             this->produceFromAfArray("mag", af::abs(afInput));
             this->produceFromAfArray("phase", af::arg(afInput));
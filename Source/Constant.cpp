@@ -49,6 +49,8 @@ class Constant: public ArrayFireBlock
             {
                 return;
             }
+
+            this->configArrayFire();
             
             this->produceFromAfArray(
                 0,
@@ -1,7 +1,9 @@
 // Copyright (c) 2019-2020,2023 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include "FFTPlanCache.hpp"
 #include "OneToOneBlock.hpp"
+#include "SignalUtility.hpp"
 #include "Utility.hpp"
 
 #include <Pothos/Exception.hpp>
@@ -10,7 +12,10 @@
 
 #include <arrayfire.h>
 
+#include <algorithm>
+#include <cmath>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 // Resolve overloads
@@ -19,6 +24,34 @@ using FFTConvolveFuncPtr = af::array(*)(
                                const af::array&,
                                const af::convMode);
 
+//
+// Misc
+//
+
+// Each overlap-add FFT produces (fftSize - numTaps + 1) new outputs, so the
+// cost per output is roughly fftSize*log2(fftSize)/(fftSize - numTaps + 1).
+// The minimum size keeps each block at least as long as a tail, and sizes
+// past what a typical chunk fills would mostly transform padding.
+static size_t chooseOverlapAddFFTSize(size_t numTaps, size_t chunkSize)
+{
+    const size_t minFFTSize = nextPowerOfTwo((2 * numTaps) - 1);
+    const size_t maxFFTSize = std::max(minFFTSize, nextPowerOfTwo(chunkSize + numTaps - 1));
+
+    size_t bestFFTSize = minFFTSize;
+    double bestCost = 0.0;
+    for(size_t fftSize = minFFTSize; fftSize <= maxFFTSize; fftSize <<= 1)
+    {
+        const double cost = (fftSize * std::log2(static_cast<double>(fftSize))) / (fftSize - numTaps + 1);
+        if((fftSize == minFFTSize) || (cost < bestCost))
+        {
+            bestFFTSize = fftSize;
+            bestCost = cost;
+        }
+    }
+
+    return bestFFTSize;
+}
+
 //
 // Block classes
 //
@@ -85,8 +118,11 @@ class ConvolveBaseBlock: public OneToOneBlock
             }
 
             _taps = taps;
-            _func.bind(Pothos::Object(_taps).convert<af::array>(), 1);
+            _afTaps = Pothos::Object(_taps).convert<af::array>();
+            _func.bind(_afTaps, 1);
             _waitTapsArmed = false; // We have taps
+
+            this->_tapsChanged();
         }
 
         std::string mode() const
@@ -120,11 +156,17 @@ class ConvolveBaseBlock: public OneToOneBlock
             OneToOneBlock::work();
         }
 
-    private:
+    protected:
         std::vector<TapType> _taps;
+        af::array _afTaps;
         af::convMode _convMode;
         bool _waitTaps;
         bool _waitTapsArmed;
+
+        // For subclasses that derive state from the taps. Since this is
+        // called from the constructor, subclasses must also call their
+        // version in their own constructors.
+        virtual void _tapsChanged() {}
 };
 
 template <typename T>
@@ -170,7 +212,258 @@ class ConvolveBlock: public ConvolveBaseBlock<T>
 };
 
 template <typename T>
-using FFTConvolveBlock = ConvolveBaseBlock<T>;
+class FFTConvolveBlock: public ConvolveBaseBlock<T>
+{
+    public:
+        using Class = FFTConvolveBlock<T>;
+
+        static const Pothos::DType dtype;
+
+        FFTConvolveBlock(
+            const std::string& device,
+            size_t dtypeDim,
+            const Pothos::Callable& callable
+        ):
+            ConvolveBaseBlock<T>(device, dtypeDim, callable),
+            _streaming(false),
+            _fftSize(0),
+            _typicalChunkSize(0),
+            _chunkSizeAtLastChoice(0)
+        {
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, streaming));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, setStreaming));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, fftSize));
+
+            this->_tapsChanged();
+        }
+
+        virtual ~FFTConvolveBlock() = default;
+
+        void activate() override
+        {
+            ConvolveBaseBlock<T>::activate();
+
+            this->_resetTail();
+            this->_reservePlans();
+        }
+
+        void deactivate() override
+        {
+            ConvolveBaseBlock<T>::deactivate();
+
+            _planReservation.release();
+        }
+
+        bool streaming() const
+        {
+            return _streaming;
+        }
+
+        void setStreaming(bool streaming)
+        {
+            if(streaming && !std::is_floating_point<T>::value && !IsComplex<T>::value)
+            {
+                throw Pothos::InvalidArgumentException("Streaming mode requires a floating-point type.");
+            }
+
+            _streaming = streaming;
+            this->_tapsChanged();
+            this->_resetTail();
+        }
+
+        // The overlap-add FFT size, or 0 if not streaming
+        size_t fftSize() const
+        {
+            return _fftSize;
+        }
+
+        void work() override
+        {
+            if(!_streaming)
+            {
+                ConvolveBaseBlock<T>::work();
+                return;
+            }
+
+            // If specified, don't do anything until taps are explicitly set.
+            if(this->_waitTapsArmed) return;
+
+            // The thread may have changed since the block was created, so make sure
+            // the backend and device still match.
+            this->configArrayFire();
+
+            const size_t elems = this->getBatchElements(this->workInfo().minElements);
+            if(0 == elems)
+            {
+                this->flushPipelinedOutputs();
+                return;
+            }
+
+            auto afInput = this->getInputPortAsAfArray(0);
+            this->_updateChunkSize(afInput.elements());
+
+            this->produceFromAfArray(0, this->_overlapAdd(afInput));
+        }
+
+    protected:
+        void _tapsChanged() override
+        {
+            if(_streaming)
+            {
+                this->configArrayFire();
+
+                const size_t chunkSize = (_typicalChunkSize > 0) ? _typicalChunkSize : (4 * this->_taps.size());
+                _fftSize = chooseOverlapAddFFTSize(this->_taps.size(), chunkSize);
+                _afTapsFFT = af::fft(this->_afTaps, static_cast<dim_t>(_fftSize));
+                _chunkSizeAtLastChoice = chunkSize;
+            }
+            else
+            {
+                _fftSize = 0;
+                _afTapsFFT = af::array();
+            }
+            if(this->isActive()) this->_reservePlans();
+
+            // Keep the tail if only its contents changed, since it still
+            // lines up with the input.
+            if(static_cast<size_t>(_afTail.elements()) != (this->_taps.size() - 1))
+            {
+                this->_resetTail();
+            }
+        }
+
+    private:
+        bool _streaming;
+
+        size_t _fftSize;
+        af::array _afTapsFFT;
+
+        // The last (numTaps-1) outputs' partial sums, which the next input
+        // adds to, kept on the device.
+        af::array _afTail;
+
+        // A running average of the input chunk size, to pick the FFT size
+        size_t _typicalChunkSize;
+        size_t _chunkSizeAtLastChoice;
+
+        FFTPlanReservation _planReservation;
+
+        // The taps' transform, and the blocks' forward and inverse
+        // transforms at the chunk size the FFT size was picked for
+        void _reservePlans()
+        {
+            if(0 == _fftSize)
+            {
+                _planReservation.release();
+                return;
+            }
+
+            const auto afDType = Pothos::Object(Class::dtype).convert<af::dtype>();
+            const size_t blockSize = _fftSize - (this->_taps.size() - 1);
+            const size_t numBlocks = std::max<size_t>(1, (_chunkSizeAtLastChoice + blockSize - 1) / blockSize);
+
+            _planReservation.reserve(
+                this->_afBackend,
+                this->_afDevice,
+                {getC2CFFTPlanKey(afDType, _fftSize, 1),
+                 getC2CFFTPlanKey(afDType, _fftSize, numBlocks)});
+        }
+
+        void _resetTail()
+        {
+            if(this->_taps.size() > 1)
+            {
+                _afTail = af::constant(
+                              0,
+                              static_cast<dim_t>(this->_taps.size()-1),
+                              Pothos::Object(Class::dtype).convert<af::dtype>());
+            }
+            else _afTail = af::array();
+        }
+
+        void _updateChunkSize(size_t chunkSize)
+        {
+            _typicalChunkSize = (0 == _typicalChunkSize) ? chunkSize
+                                                         : (((3 * _typicalChunkSize) + chunkSize) / 4);
+
+            // Only pick a new FFT size (and recompute the taps' FFT) when the
+            // chunk size has changed significantly, so it doesn't thrash.
+            const bool hasGrown = (_typicalChunkSize > (2 * _chunkSizeAtLastChoice));
+            const bool hasShrunk = ((2 * _typicalChunkSize) < _chunkSizeAtLastChoice);
+            if(hasGrown || hasShrunk)
+            {
+                const auto newFFTSize = chooseOverlapAddFFTSize(this->_taps.size(), _typicalChunkSize);
+                if(newFFTSize != _fftSize)
+                {
+                    _fftSize = newFFTSize;
+                    _afTapsFFT = af::fft(this->_afTaps, static_cast<dim_t>(_fftSize));
+                }
+                _chunkSizeAtLastChoice = _typicalChunkSize;
+                this->_reservePlans();
+            }
+        }
+
+        af::array _overlapAdd(const af::array& afInput)
+        {
+            const size_t numInputs = afInput.elements();
+            const size_t overlap = this->_taps.size() - 1;
+            const size_t blockSize = _fftSize - overlap;
+            const size_t numBlocks = (numInputs + blockSize - 1) / blockSize;
+            const size_t paddedLength = numBlocks * blockSize;
+
+            auto afPaddedInput = afInput;
+            if(paddedLength > numInputs)
+            {
+                afPaddedInput = af::join(
+                                    0,
+                                    afInput,
+                                    af::constant(
+                                        0,
+                                        static_cast<dim_t>(paddedLength - numInputs),
+                                        afInput.type()));
+            }
+
+            // All blocks are transformed in one batch. Zero-padding each to
+            // the FFT size leaves room for its full convolution, so nothing
+            // wraps around.
+            auto afBlocks = af::moddims(afPaddedInput, static_cast<dim_t>(blockSize), static_cast<dim_t>(numBlocks));
+            af::array afConvolved = af::ifft(
+                                        af::fft(afBlocks, static_cast<dim_t>(_fftSize)) *
+                                        af::tile(_afTapsFFT, 1, static_cast<unsigned>(numBlocks)));
+            if(!afInput.iscomplex()) afConvolved = af::real(afConvolved);
+
+            // Each block's first blockSize outputs line up with its input, and
+            // the rest spill into the next block, which is at least as long.
+            // Lay both out over the whole chunk plus one tail, and add them,
+            // along with the previous chunk's tail.
+            const size_t fullLength = paddedLength + overlap;
+            af::array afFull = af::flat(afConvolved(af::seq(0, static_cast<double>(blockSize-1)), af::span));
+            if(overlap > 0)
+            {
+                const auto afZeroTail = af::constant(0, static_cast<dim_t>(overlap), afFull.type());
+                const auto afSpills = af::flat(af::join(
+                                          0,
+                                          afConvolved(af::seq(static_cast<double>(blockSize), static_cast<double>(_fftSize-1)), af::span),
+                                          af::constant(
+                                              0,
+                                              static_cast<dim_t>(blockSize - overlap),
+                                              static_cast<dim_t>(numBlocks),
+                                              afFull.type())));
+
+                afFull = af::join(0, afFull, afZeroTail)
+                       + af::join(0, af::constant(0, static_cast<dim_t>(blockSize), afFull.type()), afSpills)(af::seq(0, static_cast<double>(fullLength-1)))
+                       + af::join(0, _afTail, af::constant(0, static_cast<dim_t>(fullLength - overlap), afFull.type()));
+
+                _afTail = afFull(af::seq(static_cast<double>(numInputs), static_cast<double>(numInputs + overlap - 1)));
+                _afTail.eval();
+            }
+
+            return afFull(af::seq(0, static_cast<double>(numInputs-1)));
+        }
+};
+
+template <typename T>
+const Pothos::DType FFTConvolveBlock<T>::dtype(typeid(T));
 
 //
 // Factories
@@ -304,6 +597,13 @@ static Pothos::BlockRegistry registerConvolve(
  * taps using an FFT. The taps can be set at runtime by connecting the output of a FIR Designer
  * block to <b>"setTaps"</b>.
  *
+ * By default, each input chunk is convolved on its own. In streaming mode, the
+ * input is filtered as one continuous stream with overlap-add, for floating-point
+ * types. Each output lines up with its input, and the convolution tails carry
+ * over between chunks on the device. The taps' FFT is computed only when the taps
+ * change, and the FFT size is chosen from the number of taps and the typical
+ * input chunk size. The convolution mode doesn't apply in streaming mode.
+ *
  * |category /GPU/Signal
  * |category /Filter/GPU
  * |keywords array tap taps convolution
@@ -311,6 +611,7 @@ static Pothos::BlockRegistry registerConvolve(
  * |setter setTaps(taps)
  * |setter setMode(mode)
  * |setter setWaitTaps(waitTaps)
+ * |setter setStreaming(streaming)
  *
  * |param device[Device] Device to use for processing.
  * |default "Auto"
@@ -341,6 +642,11 @@ static Pothos::BlockRegistry registerConvolve(
  * |widget ToggleSwitch(on="True", off="False")
  * |default false
  * |preview disable
+ *
+ * |param streaming[Streaming] Filter the input as one continuous stream with overlap-add.
+ * |widget ToggleSwitch(on="True", off="False")
+ * |default false
+ * |preview enable
  */
 static Pothos::BlockRegistry registerFFTConvolve(
     "/gpu/signal/fftconvolve",
@@ -47,6 +47,8 @@ class CorrCoefBlock: public ArrayFireBlock
                 return;
             }
 
+            this->configArrayFire();
+
             auto afInput0 = this->getInputPortAsAfArray(0);
             auto afInput1 = this->getInputPortAsAfArray(1);
 
@@ -56,6 +56,8 @@ class CovarianceBlock: public ArrayFireBlock
                 return;
             }
 
+            this->configArrayFire();
+
             auto afInput0 = this->getInputPortAsAfArray(0);
             auto afInput1 = this->getInputPortAsAfArray(1);
 
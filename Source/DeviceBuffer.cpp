@@ -0,0 +1,184 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "ArrayFireContext.hpp"
+#include "DeviceBuffer.hpp"
+
+#include <Pothos/Exception.hpp>
+#include <Pothos/Framework.hpp>
+#include <Pothos/Object.hpp>
+
+#include <arrayfire.h>
+
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+//
+// Since a SharedBuffer's container is type-erased, keep track of which
+// containers are ours so we never cast an unrelated container.
+//
+
+static std::mutex& getRegistryMutex()
+{
+    static std::mutex registryMutex;
+    return registryMutex;
+}
+
+static std::unordered_set<const void*>& getContainerRegistry()
+{
+    static std::unordered_set<const void*> containerRegistry;
+    return containerRegistry;
+}
+
+class AfDeviceBufferContainer
+{
+    public:
+        AfDeviceBufferContainer(const af::array& afArray, bool deferEvaluation):
+            _afArray(af::flat(afArray)),
+            _backend(af::getBackendId(afArray)),
+            _device(af::getDeviceId(afArray)),
+            _elements(afArray.elements()),
+            _isEvaluated(!deferEvaluation),
+            _numAccesses(0)
+        {
+            // Otherwise, evaluate in the producer's thread so the consumer
+            // only waits on finished data.
+            if(_isEvaluated) _afArray.eval();
+
+            std::lock_guard<std::mutex> lock(getRegistryMutex());
+            getContainerRegistry().insert(this);
+        }
+
+        virtual ~AfDeviceBufferContainer()
+        {
+            std::lock_guard<std::mutex> lock(getRegistryMutex());
+            getContainerRegistry().erase(this);
+        }
+
+        inline dim_t elements() const
+        {
+            return _elements;
+        }
+
+        // Returns a copy of the handle, since consumers in multiple threads
+        // may share the container, and evaluating or indexing an unevaluated
+        // array modifies it. Only the first access of the whole array can
+        // extend a deferred expression. Slices and later accesses would each
+        // re-run the whole expression, so those evaluate it once here. The
+        // caller must have the array's backend and device active.
+        af::array afArray(bool isWholeArray)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            const bool mustEvaluate = !isWholeArray || (_numAccesses > 0);
+            ++_numAccesses;
+
+            if(mustEvaluate && !_isEvaluated)
+            {
+                _afArray.eval();
+                _isEvaluated = true;
+            }
+
+            return _afArray;
+        }
+
+        inline af::Backend backend() const
+        {
+            return _backend;
+        }
+
+        inline int device() const
+        {
+            return _device;
+        }
+
+    private:
+        std::mutex _mutex;
+        af::array _afArray;
+        af::Backend _backend;
+        int _device;
+        dim_t _elements;
+        bool _isEvaluated;
+        size_t _numAccesses;
+};
+
+Pothos::BufferChunk afArrayToDeviceBufferChunk(
+    const af::array& afArray,
+    bool deferEvaluation)
+{
+    auto containerSPtr = std::make_shared<AfDeviceBufferContainer>(afArray, deferEvaluation);
+
+    // There is no host address, so use the container's address as a unique
+    // placeholder. This lets consumers calculate offsets after partial
+    // consumption.
+    Pothos::SharedBuffer sharedBuffer(
+        reinterpret_cast<size_t>(containerSPtr.get()),
+        afArray.bytes(),
+        containerSPtr);
+
+    auto bufferChunk = Pothos::BufferChunk(sharedBuffer);
+    bufferChunk.dtype = Pothos::Object(afArray.type()).convert<Pothos::DType>();
+
+    return bufferChunk;
+}
+
+bool isDeviceBufferChunk(const Pothos::BufferChunk& bufferChunk)
+{
+    const auto& sharedBuffer = bufferChunk.getBuffer();
+    const auto* container = sharedBuffer.getContainer().get();
+    if(!container || (sharedBuffer.getAddress() != reinterpret_cast<size_t>(container)))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(getRegistryMutex());
+    return (getContainerRegistry().count(container) > 0);
+}
+
+af::array deviceBufferChunkToAfArray(const Pothos::BufferChunk& bufferChunk)
+{
+    if(!isDeviceBufferChunk(bufferChunk))
+    {
+        throw Pothos::AssertionViolationException("The given BufferChunk is not device-resident.");
+    }
+
+    const auto& sharedBuffer = bufferChunk.getBuffer();
+    auto containerSPtr = std::static_pointer_cast<AfDeviceBufferContainer>(sharedBuffer.getContainer());
+
+    const auto elemSize = bufferChunk.dtype.size();
+    const auto offset = static_cast<dim_t>((bufferChunk.address - sharedBuffer.getAddress()) / elemSize);
+    const auto elems = static_cast<dim_t>(bufferChunk.elements());
+
+    const bool isWholeArray = (0 == offset) && (elems == containerSPtr->elements());
+    const bool isActiveDevice = (containerSPtr->backend() == af::getActiveBackend()) &&
+                                (containerSPtr->device() == af::getDevice());
+    if(isActiveDevice)
+    {
+        const af::array afArray = containerSPtr->afArray(isWholeArray);
+
+        if(isWholeArray) return afArray;
+        else             return afArray(af::seq(static_cast<double>(offset), static_cast<double>(offset+elems-1)));
+    }
+
+    // The array lives on another device, so stage it through host memory.
+    const auto activeBackend = af::getActiveBackend();
+    const auto activeDevice = af::getDevice();
+
+    std::vector<unsigned char> hostBuffer(bufferChunk.length);
+
+    setThreadArrayFireContext(containerSPtr->backend(), containerSPtr->device());
+
+    // Nothing can be fused across devices, so don't defer evaluation.
+    const af::array afArray = containerSPtr->afArray(false);
+    if(isWholeArray) afArray.host(hostBuffer.data());
+    else             afArray(af::seq(static_cast<double>(offset), static_cast<double>(offset+elems-1))).host(hostBuffer.data());
+
+    setThreadArrayFireContext(activeBackend, activeDevice);
+
+    af::array ret(elems, afArray.type());
+    ret.write<unsigned char>(hostBuffer.data(), bufferChunk.length, ::afHost);
+
+    return ret;
+}
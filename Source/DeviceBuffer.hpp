@@ -0,0 +1,31 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <Pothos/Framework.hpp>
+
+#include <arrayfire.h>
+
+//
+// Device-resident Pothos::BufferChunk <-> af::array
+//
+// These buffer chunks wrap an af::array handle instead of host memory and are
+// only passed between ArrayFire blocks whose ports share a domain. Their
+// addresses do not point to host memory and must never be dereferenced.
+//
+
+// If evaluation is deferred, the consumer extends the array's unevaluated
+// expression, so ArrayFire's JIT fuses the producer's and consumer's
+// element-wise operations into a single kernel. This only applies to the
+// first consumer of the whole array. Partial consumption evaluates it once.
+Pothos::BufferChunk afArrayToDeviceBufferChunk(
+    const af::array& afArray,
+    bool deferEvaluation = false);
+
+bool isDeviceBufferChunk(const Pothos::BufferChunk& bufferChunk);
+
+// Returns the buffer chunk's contents on the active backend and device. If the
+// underlying af::array lives on another device, it is staged through host
+// memory.
+af::array deviceBufferChunkToAfArray(const Pothos::BufferChunk& bufferChunk);
@@ -1,6 +1,7 @@
 // Copyright (c) 2019-2020 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include "ArrayFireContext.hpp"
 #include "DeviceCache.hpp"
 #include "Utility.hpp"
 
@@ -98,7 +99,7 @@ static std::vector<af::Backend> _getAvailableBackends()
         {
             if(::AF_BACKEND_CUDA == backend)
             {
-                af::setBackend(backend);
+                setThreadArrayFireBackend(backend);
                 if(af::getDeviceCount() > 0)
                 {
                     static constexpr size_t bufferLen = 1024;
@@ -130,7 +131,7 @@ static std::vector<DeviceCacheEntry> _getDeviceCache()
 
     for(const auto& backend: getAvailableBackends())
     {
-        af::setBackend(backend);
+        setThreadArrayFireBackend(backend);
 
         // For current backend
         const int numDevices = af::getDeviceCount();
@@ -142,7 +143,7 @@ static std::vector<DeviceCacheEntry> _getDeviceCache()
             char platform[bufferLen] = {0};
             char toolkit[bufferLen] = {0};
             char compute[bufferLen] = {0};
-            af::setDevice(devIndex);
+            setThreadArrayFireContext(backend, devIndex);
             af::deviceInfo(name, platform, toolkit, compute);
 
             DeviceCacheEntry deviceCacheEntry =
@@ -0,0 +1,319 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "ArrayFireContext.hpp"
+#include "DeviceCache.hpp"
+#include "DeviceProfile.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <Pothos/Exception.hpp>
+#include <Pothos/Plugin.hpp>
+#include <Pothos/System/Paths.hpp>
+
+#include <Poco/File.h>
+#include <Poco/Logger.h>
+#include <Poco/Path.h>
+
+#include <arrayfire.h>
+
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+static const std::vector<DeviceOpClass> AllOpClasses =
+{
+    DeviceOpClass::Elementwise,
+    DeviceOpClass::Transcendental,
+    DeviceOpClass::FFT
+};
+
+static constexpr size_t ProfileChunkElements = 8192;
+
+static constexpr size_t NumBenchmarkIterations = 10;
+
+// Bump this if the benchmarks change, to invalidate stored profiles.
+static constexpr int ProfileVersion = 2;
+
+static Poco::Logger& getLogger()
+{
+    auto& logger = Poco::Logger::get("PothosGPU");
+    return logger;
+}
+
+std::string deviceOpClassToString(DeviceOpClass opClass)
+{
+    switch(opClass)
+    {
+        case DeviceOpClass::Elementwise:
+            return "Elementwise";
+
+        case DeviceOpClass::Transcendental:
+            return "Transcendental";
+
+        case DeviceOpClass::FFT:
+            return "FFT";
+    }
+
+    throw Pothos::AssertionViolationException("Invalid DeviceOpClass");
+}
+
+//
+// Benchmarking
+//
+
+static af::array runOp(DeviceOpClass opClass, const af::array& afInput)
+{
+    switch(opClass)
+    {
+        case DeviceOpClass::Elementwise:
+            return (afInput * 2.0f) + 1.0f;
+
+        case DeviceOpClass::Transcendental:
+            return af::sin(afInput) * af::exp(afInput);
+
+        case DeviceOpClass::FFT:
+            return af::fft(afInput);
+    }
+
+    throw Pothos::AssertionViolationException("Invalid DeviceOpClass");
+}
+
+// Average seconds per chunk, including the transfers to and from the host
+// a block with host ports would see.
+static double benchmarkOp(DeviceOpClass opClass)
+{
+    const std::vector<float> input(ProfileChunkElements, 0.5f);
+    std::vector<unsigned char> output;
+
+    auto runOnce = [&]()
+    {
+        af::array afInput(static_cast<dim_t>(ProfileChunkElements), input.data());
+        auto afOutput = runOp(opClass, afInput);
+
+        output.resize(afOutput.bytes());
+        afOutput.host(output.data());
+    };
+
+    // Don't count JIT compilation or FFT plan creation.
+    runOnce();
+
+    auto timer = af::timer::start();
+    for(size_t i = 0; i < NumBenchmarkIterations; ++i) runOnce();
+
+    return af::timer::stop(timer) / NumBenchmarkIterations;
+}
+
+static json benchmarkDevice(const DeviceCacheEntry& entry)
+{
+    setThreadArrayFireContext(entry.afBackendEnum, entry.afDeviceIndex);
+
+    json deviceJSON;
+    for(DeviceOpClass opClass: AllOpClasses)
+    {
+        deviceJSON[deviceOpClassToString(opClass)] = benchmarkOp(opClass);
+    }
+
+    return deviceJSON;
+}
+
+//
+// Storage
+//
+
+static std::string getProfilePath()
+{
+    Poco::Path path(Pothos::System::getUserDataPath());
+    path.append("PothosGPU");
+    path.append("DeviceProfile.json");
+
+    return path.toString();
+}
+
+static std::vector<std::string> getDeviceNames()
+{
+    std::vector<std::string> deviceNames;
+    for(const auto& entry: getDeviceCache()) deviceNames.emplace_back(entry.name);
+
+    return deviceNames;
+}
+
+// Every device needs a time for every op class, or selection would read a
+// missing entry.
+static bool areProfileResultsComplete(const json& results)
+{
+    if(!results.is_object()) return false;
+
+    for(const auto& deviceName: getDeviceNames())
+    {
+        const auto deviceIter = results.find(deviceName);
+        if((results.end() == deviceIter) || !deviceIter->is_object()) return false;
+
+        for(DeviceOpClass opClass: AllOpClasses)
+        {
+            const auto timeIter = deviceIter->find(deviceOpClassToString(opClass));
+            if((deviceIter->end() == timeIter) || !timeIter->is_number()) return false;
+        }
+    }
+
+    return true;
+}
+
+// A stored profile is only valid for the devices and ArrayFire version it
+// was measured with.
+static bool isProfileValid(const json& profile)
+{
+    return (profile.value("Version", 0) == ProfileVersion) &&
+           (profile.value("ArrayFire Version", std::string()) == AF_VERSION) &&
+           (profile.value("Devices", std::vector<std::string>()) == getDeviceNames()) &&
+           profile.contains("Results") &&
+           areProfileResultsComplete(profile.at("Results"));
+}
+
+static json loadProfile()
+{
+    json profile;
+
+    std::ifstream stream(getProfilePath());
+    if(stream.good())
+    {
+        try {profile = json::parse(stream);}
+        catch(...) {profile = json();}
+    }
+
+    return profile;
+}
+
+static void saveProfile(const json& profile)
+{
+    const Poco::Path path(getProfilePath());
+
+    try
+    {
+        Poco::File(path.parent()).createDirectories();
+
+        std::ofstream stream(path.toString());
+        stream << profile.dump(4);
+    }
+    catch(const std::exception& ex)
+    {
+        poco_warning_f2(
+            getLogger(),
+            "Could not save device profile to %s: %s",
+            path.toString(),
+            std::string(ex.what()));
+    }
+}
+
+//
+// Cached profile
+//
+
+static std::mutex deviceProfileMutex;
+static json deviceProfile;
+static bool isDeviceProfileLoaded = false;
+
+// Assumes the mutex is held. Returns null if there is no valid profile.
+static const json& getDeviceProfileResults()
+{
+    static const json NoResults;
+
+    if(!isDeviceProfileLoaded)
+    {
+        deviceProfile = loadProfile();
+        isDeviceProfileLoaded = true;
+
+        if(!isProfileValid(deviceProfile))
+        {
+            poco_information(
+                getLogger(),
+                "No device profile found, so \"Auto\" uses the first device. "
+                "Call /gpu/profile_devices to benchmark the available devices.");
+        }
+    }
+
+    return isProfileValid(deviceProfile) ? deviceProfile.at("Results") : NoResults;
+}
+
+void profileDevices()
+{
+    // Benchmark without the lock so blocks can still be created meanwhile.
+    json profile;
+    profile["Version"] = ProfileVersion;
+    profile["ArrayFire Version"] = AF_VERSION;
+    profile["Devices"] = getDeviceNames();
+
+    const auto callerBackend = af::getActiveBackend();
+    const int callerDevice = af::getDevice();
+
+    auto& results = profile["Results"];
+    for(const auto& entry: getDeviceCache())
+    {
+        results[entry.name] = benchmarkDevice(entry);
+    }
+
+    setThreadArrayFireContext(callerBackend, callerDevice);
+    saveProfile(profile);
+
+    std::lock_guard<std::mutex> lock(deviceProfileMutex);
+    deviceProfile = profile;
+    isDeviceProfileLoaded = true;
+}
+
+//
+// Selection
+//
+
+std::string getAutoDevice(DeviceOpClass opClass)
+{
+    const auto& deviceCache = getDeviceCache();
+    if(deviceCache.empty())
+    {
+        throw Pothos::RuntimeException("No ArrayFire devices found. Check your ArrayFire installation.");
+    }
+
+    // Nothing to choose between, so don't bother loading the profile.
+    if(1 == deviceCache.size()) return deviceCache[0].name;
+
+    std::lock_guard<std::mutex> lock(deviceProfileMutex);
+
+    const auto& results = getDeviceProfileResults();
+    if(results.is_null()) return deviceCache[0].name;
+
+    const auto opClassStr = deviceOpClassToString(opClass);
+
+    std::string bestDevice = deviceCache[0].name;
+    double bestTime = std::numeric_limits<double>::max();
+    for(const auto& entry: deviceCache)
+    {
+        const double time = results.at(entry.name).at(opClassStr).get<double>();
+        if(time < bestTime)
+        {
+            bestDevice = entry.name;
+            bestTime = time;
+        }
+    }
+
+    return bestDevice;
+}
+
+std::string getAutoDeviceSelectionsJSON()
+{
+    json selections;
+    for(DeviceOpClass opClass: AllOpClasses)
+    {
+        selections[deviceOpClassToString(opClass)] = getAutoDevice(opClass);
+    }
+
+    return selections.dump();
+}
+
+pothos_static_block(registerDeviceProfile)
+{
+    Pothos::PluginRegistry::addCall(
+        "/gpu/profile_devices", &profileDevices);
+}
@@ -0,0 +1,38 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <string>
+
+//
+// Benchmark-driven "Auto" device selection
+//
+// The fastest device depends on what a block does. Each device is benchmarked
+// on a representative operation per class, including transfers to and from
+// the host, and the results are stored in the user data directory. A block's
+// chunk size isn't known until it runs, so every class is benchmarked at a
+// single typical chunk size.
+//
+// Benchmarking takes a while, so it only runs when explicitly requested with
+// profileDevices() (/gpu/profile_devices). Until a valid profile is stored,
+// "Auto" uses the first device in the device cache.
+//
+
+enum class DeviceOpClass
+{
+    Elementwise,
+    Transcendental,
+    FFT
+};
+
+std::string deviceOpClassToString(DeviceOpClass opClass);
+
+// Returns the name of the fastest device in the device cache.
+std::string getAutoDevice(DeviceOpClass opClass);
+
+// Benchmarks every device and stores the results for later runs.
+void profileDevices();
+
+// JSON object of the device chosen for each operation class.
+std::string getAutoDeviceSelectionsJSON();
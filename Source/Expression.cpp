@@ -0,0 +1,553 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "ArrayFireBlock.hpp"
+#include "Functions.hpp"
+#include "Utility.hpp"
+
+#include <Pothos/Exception.hpp>
+#include <Pothos/Framework.hpp>
+#include <Pothos/Object.hpp>
+
+#include <Poco/Format.h>
+#include <Poco/NumberFormatter.h>
+
+#include <arrayfire.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//
+// Expression compilation
+//
+// The expression is parsed once into a tree of functions that build the
+// equivalent af::array expression. Nothing is evaluated until the output is
+// produced, so ArrayFire's JIT compiles the whole expression into one kernel.
+// Variables are read through pointers into the block's variable map, so they
+// can be changed without reparsing.
+//
+
+struct ExpressionInputs
+{
+    const std::vector<af::array>& inputs;
+    dim_t elems;
+    af::dtype dtype;
+};
+
+using ExpressionNode = std::function<af::array(const ExpressionInputs&)>;
+
+using UnaryFunc = af::array(*)(const af::array&);
+using BinaryFunc = af::array(*)(const af::array&, const af::array&);
+
+#define UNARY_FUNC_ENTRY(name, func) \
+    {name, [](const af::array& afArray) -> af::array {return func(afArray);}}
+
+#define BINARY_FUNC_ENTRY(name, func) \
+    {name, [](const af::array& afArray0, const af::array& afArray1) -> af::array {return func(afArray0, afArray1);}}
+
+// The float functions supported by individual blocks.
+static const std::unordered_map<std::string, UnaryFunc> UnaryFuncs =
+{
+    UNARY_FUNC_ENTRY("abs", af::abs),
+    UNARY_FUNC_ENTRY("round", af::round),
+    UNARY_FUNC_ENTRY("trunc", af::trunc),
+    UNARY_FUNC_ENTRY("floor", af::floor),
+    UNARY_FUNC_ENTRY("ceil", af::ceil),
+    UNARY_FUNC_ENTRY("sin", af::sin),
+    UNARY_FUNC_ENTRY("cos", af::cos),
+    UNARY_FUNC_ENTRY("tan", af::tan),
+    UNARY_FUNC_ENTRY("asin", af::asin),
+    UNARY_FUNC_ENTRY("acos", af::acos),
+    UNARY_FUNC_ENTRY("atan", af::atan),
+    UNARY_FUNC_ENTRY("sinh", af::sinh),
+    UNARY_FUNC_ENTRY("cosh", af::cosh),
+    UNARY_FUNC_ENTRY("tanh", af::tanh),
+    UNARY_FUNC_ENTRY("asinh", af::asinh),
+    UNARY_FUNC_ENTRY("acosh", af::acosh),
+    UNARY_FUNC_ENTRY("atanh", af::atanh),
+    UNARY_FUNC_ENTRY("sigmoid", af::sigmoid),
+    UNARY_FUNC_ENTRY("exp", af::exp),
+    UNARY_FUNC_ENTRY("expm1", af::expm1),
+    UNARY_FUNC_ENTRY("erf", af::erf),
+    UNARY_FUNC_ENTRY("erfc", af::erfc),
+    UNARY_FUNC_ENTRY("log", af::log),
+    UNARY_FUNC_ENTRY("log2", af::log2),
+    UNARY_FUNC_ENTRY("log10", af::log10),
+    UNARY_FUNC_ENTRY("log1p", af::log1p),
+    UNARY_FUNC_ENTRY("sqrt", af::sqrt),
+    UNARY_FUNC_ENTRY("cbrt", af::cbrt),
+    UNARY_FUNC_ENTRY("rsqrt", af::rsqrt),
+    UNARY_FUNC_ENTRY("tgamma", af::tgamma),
+    UNARY_FUNC_ENTRY("lgamma", af::lgamma),
+    UNARY_FUNC_ENTRY("sec", sec),
+    UNARY_FUNC_ENTRY("csc", csc),
+    UNARY_FUNC_ENTRY("cot", cot),
+    UNARY_FUNC_ENTRY("asec", asec),
+    UNARY_FUNC_ENTRY("acsc", acsc),
+    UNARY_FUNC_ENTRY("acot", acot),
+    UNARY_FUNC_ENTRY("sech", sech),
+    UNARY_FUNC_ENTRY("csch", csch),
+    UNARY_FUNC_ENTRY("coth", coth),
+    UNARY_FUNC_ENTRY("asech", asech),
+    UNARY_FUNC_ENTRY("acsch", acsch),
+    UNARY_FUNC_ENTRY("acoth", acoth),
+};
+
+static const std::unordered_map<std::string, BinaryFunc> BinaryFuncs =
+{
+    BINARY_FUNC_ENTRY("hypot", af::hypot),
+    BINARY_FUNC_ENTRY("rem", af::rem),
+    BINARY_FUNC_ENTRY("atan2", af::atan2),
+    BINARY_FUNC_ENTRY("pow", af::pow),
+    BINARY_FUNC_ENTRY("root", af::root),
+    BINARY_FUNC_ENTRY("min", af::min),
+    BINARY_FUNC_ENTRY("max", af::max),
+};
+
+static const std::unordered_map<std::string, double> Constants =
+{
+    {"pi", af::Pi},
+    {"e", 2.718281828459045},
+};
+
+class ExpressionParser
+{
+    public:
+        ExpressionParser(
+            const std::string& expression,
+            size_t numInputs,
+            std::map<std::string, double>& variables
+        ):
+            _expression(expression),
+            _pos(0),
+            _numInputs(numInputs),
+            _variables(variables)
+        {}
+
+        ExpressionNode parse()
+        {
+            auto node = this->parseSum();
+
+            this->skipWhitespace();
+            if(_pos < _expression.size())
+            {
+                this->throwSyntaxError("Unexpected character");
+            }
+
+            return node;
+        }
+
+        const std::set<std::string>& variableNames() const
+        {
+            return _variableNames;
+        }
+
+    private:
+        std::string _expression;
+        size_t _pos;
+        size_t _numInputs;
+        std::map<std::string, double>& _variables;
+        std::set<std::string> _variableNames;
+
+        [[noreturn]] void throwSyntaxError(const std::string& what) const
+        {
+            throw Pothos::SyntaxException(
+                      what,
+                      Poco::format(
+                          "%s (position %s)",
+                          _expression,
+                          Poco::NumberFormatter::format(_pos)));
+        }
+
+        void skipWhitespace()
+        {
+            while((_pos < _expression.size()) && std::isspace(_expression[_pos])) ++_pos;
+        }
+
+        bool accept(char c)
+        {
+            this->skipWhitespace();
+            if((_pos < _expression.size()) && (_expression[_pos] == c))
+            {
+                ++_pos;
+                return true;
+            }
+
+            return false;
+        }
+
+        void expect(char c)
+        {
+            if(!this->accept(c))
+            {
+                this->throwSyntaxError(std::string("Expected '")+c+"'");
+            }
+        }
+
+        // sum := product (('+' | '-') product)*
+        ExpressionNode parseSum()
+        {
+            auto node = this->parseProduct();
+            while(true)
+            {
+                if(this->accept('+'))
+                {
+                    auto rhs = this->parseProduct();
+                    node = [node, rhs](const ExpressionInputs& in) {return node(in) + rhs(in);};
+                }
+                else if(this->accept('-'))
+                {
+                    auto rhs = this->parseProduct();
+                    node = [node, rhs](const ExpressionInputs& in) {return node(in) - rhs(in);};
+                }
+                else return node;
+            }
+        }
+
+        // product := unary (('*' | '/') unary)*
+        ExpressionNode parseProduct()
+        {
+            auto node = this->parseUnary();
+            while(true)
+            {
+                if(this->accept('*'))
+                {
+                    auto rhs = this->parseUnary();
+                    node = [node, rhs](const ExpressionInputs& in) {return node(in) * rhs(in);};
+                }
+                else if(this->accept('/'))
+                {
+                    auto rhs = this->parseUnary();
+                    node = [node, rhs](const ExpressionInputs& in) {return node(in) / rhs(in);};
+                }
+                else return node;
+            }
+        }
+
+        // unary := ('-' | '+') unary | power
+        ExpressionNode parseUnary()
+        {
+            if(this->accept('-'))
+            {
+                auto operand = this->parseUnary();
+                return [operand](const ExpressionInputs& in) {return -operand(in);};
+            }
+            else if(this->accept('+')) return this->parseUnary();
+
+            return this->parsePower();
+        }
+
+        // power := primary ('^' unary)?, which is right-associative
+        ExpressionNode parsePower()
+        {
+            auto node = this->parsePrimary();
+            if(this->accept('^'))
+            {
+                auto exponent = this->parseUnary();
+                node = [node, exponent](const ExpressionInputs& in) {return af::pow(node(in), exponent(in));};
+            }
+
+            return node;
+        }
+
+        // primary := number | identifier | identifier '(' args ')' | '(' sum ')'
+        ExpressionNode parsePrimary()
+        {
+            this->skipWhitespace();
+            if(_pos >= _expression.size()) this->throwSyntaxError("Unexpected end of expression");
+
+            if(this->accept('('))
+            {
+                auto node = this->parseSum();
+                this->expect(')');
+
+                return node;
+            }
+
+            const char c = _expression[_pos];
+            if(std::isdigit(c) || ('.' == c)) return this->parseNumber();
+            else if(std::isalpha(c) || ('_' == c)) return this->parseIdentifier();
+
+            this->throwSyntaxError("Unexpected character");
+        }
+
+        ExpressionNode parseNumber()
+        {
+            const char* begin = _expression.c_str() + _pos;
+            char* end = nullptr;
+            const double value = std::strtod(begin, &end);
+            if(end == begin) this->throwSyntaxError("Invalid number");
+
+            _pos += (end - begin);
+
+            return [value](const ExpressionInputs& in) {return af::constant(value, in.elems, in.dtype);};
+        }
+
+        ExpressionNode parseIdentifier()
+        {
+            const size_t start = _pos;
+            while((_pos < _expression.size()) && (std::isalnum(_expression[_pos]) || ('_' == _expression[_pos]))) ++_pos;
+            const auto name = _expression.substr(start, _pos-start);
+
+            if(this->accept('(')) return this->parseCall(name);
+
+            // x is shorthand for x0.
+            const auto inputIndex = this->getInputIndex(name);
+            if(inputIndex >= 0)
+            {
+                return [inputIndex](const ExpressionInputs& in) {return in.inputs[inputIndex];};
+            }
+
+            const auto constantIter = Constants.find(name);
+            if(Constants.end() != constantIter)
+            {
+                const double value = constantIter->second;
+                return [value](const ExpressionInputs& in) {return af::constant(value, in.elems, in.dtype);};
+            }
+
+            // Anything else is a variable, which may not be set yet.
+            _variableNames.emplace(name);
+            const double* pValue = &_variables.emplace(name, 0.0).first->second;
+
+            return [pValue](const ExpressionInputs& in) {return af::constant(*pValue, in.elems, in.dtype);};
+        }
+
+        ExpressionNode parseCall(const std::string& name)
+        {
+            std::vector<ExpressionNode> args;
+            if(!this->accept(')'))
+            {
+                do {args.emplace_back(this->parseSum());} while(this->accept(','));
+                this->expect(')');
+            }
+
+            const auto unaryIter = UnaryFuncs.find(name);
+            if(UnaryFuncs.end() != unaryIter)
+            {
+                if(args.size() != 1) this->throwSyntaxError(name+"() takes 1 argument");
+
+                const auto func = unaryIter->second;
+                const auto arg = args[0];
+                return [func, arg](const ExpressionInputs& in) {return func(arg(in));};
+            }
+
+            const auto binaryIter = BinaryFuncs.find(name);
+            if(BinaryFuncs.end() != binaryIter)
+            {
+                if(args.size() != 2) this->throwSyntaxError(name+"() takes 2 arguments");
+
+                const auto func = binaryIter->second;
+                const auto arg0 = args[0];
+                const auto arg1 = args[1];
+                return [func, arg0, arg1](const ExpressionInputs& in) {return func(arg0(in), arg1(in));};
+            }
+
+            this->throwSyntaxError("Unknown function "+name+"()");
+        }
+
+        int getInputIndex(const std::string& name) const
+        {
+            if(("x" == name) && (_numInputs > 0)) return 0;
+            if((name.size() < 2) || (name[0] != 'x')) return -1;
+
+            for(size_t i = 1; i < name.size(); ++i)
+            {
+                if(!std::isdigit(name[i])) return -1;
+            }
+
+            const auto index = std::stoul(name.substr(1));
+            if(index >= _numInputs)
+            {
+                throw Pothos::RangeException(
+                          Poco::format(
+                              "Expression references %s, but the block only has %s input(s).",
+                              name,
+                              Poco::NumberFormatter::format(_numInputs)));
+            }
+
+            return static_cast<int>(index);
+        }
+};
+
+//
+// Block
+//
+
+class Expression: public ArrayFireBlock
+{
+    public:
+        static Pothos::Block* make(
+            const std::string& device,
+            const Pothos::DType& dtype,
+            size_t numInputs,
+            const std::string& expression)
+        {
+            // Supports float
+            static const DTypeSupport dtypeSupport{false,false,true,false};
+            validateDType(dtype, dtypeSupport);
+
+            return new Expression(device, dtype, numInputs, expression);
+        }
+
+        Expression(
+            const std::string& device,
+            const Pothos::DType& dtype,
+            size_t numInputs,
+            const std::string& expression
+        ):
+            ArrayFireBlock(device),
+            _numInputs(numInputs),
+            _afDType(Pothos::Object(dtype).convert<af::dtype>())
+        {
+            if(0 == _numInputs)
+            {
+                throw Pothos::InvalidArgumentException("numInputs must be > 0.");
+            }
+
+            for(size_t chan = 0; chan < _numInputs; ++chan)
+            {
+                this->setupInput(chan, dtype, _domain);
+            }
+            this->setupOutput(0, dtype, _domain);
+
+            this->registerCall(this, POTHOS_FCN_TUPLE(Expression, expression));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Expression, setExpression));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Expression, variableNames));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Expression, variable));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Expression, setVariable));
+            this->registerPipeliningCalls();
+            this->registerBatchingCalls();
+
+            this->registerProbe("expression");
+            this->registerSignal("expressionChanged");
+            this->registerSignal("variableChanged");
+
+            this->setExpression(expression);
+        }
+
+        virtual ~Expression() = default;
+
+        std::string expression() const
+        {
+            return _expression;
+        }
+
+        void setExpression(const std::string& expression)
+        {
+            // Keep the old variables in case they're set before the expression.
+            ExpressionParser parser(expression, _numInputs, _variables);
+            _node = parser.parse();
+            _variableNames = parser.variableNames();
+            _expression = expression;
+
+            this->emitSignal("expressionChanged", expression);
+        }
+
+        std::vector<std::string> variableNames() const
+        {
+            return std::vector<std::string>(_variableNames.begin(), _variableNames.end());
+        }
+
+        double variable(const std::string& name) const
+        {
+            auto variableIter = _variables.find(name);
+            if(_variables.end() == variableIter)
+            {
+                throw Pothos::NotFoundException("Unknown variable", name);
+            }
+
+            return variableIter->second;
+        }
+
+        void setVariable(const std::string& name, double value)
+        {
+            // Existing entries are updated in place, since the compiled
+            // expression points to them.
+            _variables[name] = value;
+
+            this->emitSignal("variableChanged", name, value);
+        }
+
+        void work() override
+        {
+            this->configArrayFire();
+
+            const size_t elems = this->getBatchElements(this->workInfo().minAllElements);
+            if(0 == elems)
+            {
+                this->flushPipelinedOutputs();
+                return;
+            }
+
+            std::vector<af::array> inputs;
+            for(size_t chan = 0; chan < _numInputs; ++chan)
+            {
+                inputs.emplace_back(this->getInputPortAsAfArray(chan));
+            }
+
+            const ExpressionInputs expressionInputs{inputs, static_cast<dim_t>(inputs[0].elements()), _afDType};
+            this->produceFromAfArray(0, _node(expressionInputs));
+        }
+
+    private:
+        size_t _numInputs;
+        af::dtype _afDType;
+
+        std::string _expression;
+        ExpressionNode _node;
+
+        std::map<std::string, double> _variables;
+        std::set<std::string> _variableNames;
+};
+
+/*
+ * |PothosDoc Expression (GPU)
+ *
+ * Evaluates an arithmetic expression over each element of the input streams.
+ * The whole expression is compiled into a single ArrayFire kernel, so this is
+ * much faster than chaining the equivalent blocks.
+ *
+ * Inputs are referenced as <b>x0</b>, <b>x1</b>, and so on, and <b>x</b> is
+ * shorthand for <b>x0</b>. Expressions support <b>+</b>, <b>-</b>, <b>*</b>,
+ * <b>/</b>, <b>^</b>, parentheses, the constants <b>pi</b> and <b>e</b>, and
+ * the same float functions as the individual GPU blocks, including
+ * <b>hypot</b>, <b>rem</b>, <b>atan2</b>, <b>pow</b>, <b>root</b>,
+ * <b>min</b>, and <b>max</b>.
+ *
+ * Any other name is a scalar variable, set with <b>setVariable</b>. Variables
+ * default to 0 and can be changed at runtime without recompiling the
+ * expression.
+ *
+ * |category /GPU/Arith
+ * |category /Math/GPU
+ * |keywords math arithmetic formula fused jit
+ * |factory /gpu/arith/expression(device,dtype,numInputs,expression)
+ * |setter setExpression(expression)
+ *
+ * |param device[Device] Device to use for processing.
+ * |default "Auto"
+ *
+ * |param dtype[Data Type] The data type used in the arithmetic.
+ * |widget DTypeChooser(float=1,dim=1)
+ * |default "float64"
+ * |preview enable
+ *
+ * |param numInputs[Num Inputs] The number of input channels.
+ * |widget SpinBox(minimum=1)
+ * |default 1
+ * |preview disable
+ *
+ * |param expression[Expression] The expression to evaluate.
+ * |widget StringEntry()
+ * |default "x"
+ * |preview enable
+ */
+static Pothos::BlockRegistry registerExpression(
+    "/gpu/arith/expression",
+    Pothos::Callable(&Expression::make));
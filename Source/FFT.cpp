@@ -3,6 +3,7 @@
 
 #include "ArrayFireBlock.hpp"
 #include "BufferConversions.hpp"
+#include "FFTPlanCache.hpp"
 #include "Utility.hpp"
 
 #include <Pothos/Callable.hpp>
@@ -13,10 +14,12 @@
 
 #include <arrayfire.h>
 
+#include <algorithm>
 #include <cmath>
 #include <functional>
 #include <string>
 #include <typeinfo>
+#include <vector>
 
 //
 // Misc
@@ -27,8 +30,18 @@ static inline bool isPowerOfTwo(size_t num)
     return (0 != num) && ((num & (num - 1)) == 0);
 }
 
+static inline size_t floorPowerOfTwo(size_t num)
+{
+    size_t ret = 1;
+    while((ret << 1) <= num) ret <<= 1;
+
+    return ret;
+}
+
 static const std::string fftBlockPath = "/gpu/signal/fft";
 
+static constexpr size_t DefaultMaxFramesPerCall = 64;
+
 //
 // Block classes
 //
@@ -52,11 +65,12 @@ class FFTBlock: public ArrayFireBlock
             size_t dtypeDims,
             bool enforceNumBins
         ):
-            ArrayFireBlock(device),
+            ArrayFireBlock(device, DeviceOpClass::FFT),
             _func(func),
             _enforceNumBins(enforceNumBins),
             _numBins(numBins),
-            _norm(0.0) // Set with class setter
+            _norm(0.0), // Set with class setter
+            _maxFramesPerCall(DefaultMaxFramesPerCall)
         {
             if(_enforceNumBins && !isPowerOfTwo(numBins))
             {
@@ -80,10 +94,13 @@ class FFTBlock: public ArrayFireBlock
             static const Pothos::DType inDType(typeid(InType));
             static const Pothos::DType outDType(typeid(OutType));
 
+            // The input reserve may require merging buffers on the host,
+            // which device-resident buffers don't support, so only accept
+            // them when we consume whatever is given.
             this->setupInput(
                 0,
                 Pothos::DType::fromDType(inDType, dtypeDims),
-                _domain);
+                _enforceNumBins ? "" : _domain);
             this->setupOutput(
                 0,
                 Pothos::DType::fromDType(outDType, dtypeDims),
@@ -100,10 +117,26 @@ class FFTBlock: public ArrayFireBlock
 
             this->registerCall(this, POTHOS_FCN_TUPLE(Class, normalizationFactor));
             this->registerCall(this, POTHOS_FCN_TUPLE(Class, setNormalizationFactor));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, maxFramesPerCall));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, setMaxFramesPerCall));
         }
 
         virtual ~FFTBlock() = default;
 
+        void activate() override
+        {
+            ArrayFireBlock::activate();
+
+            this->_warmUpPlans();
+        }
+
+        void deactivate() override
+        {
+            ArrayFireBlock::deactivate();
+
+            _planReservation.release();
+        }
+
         double normalizationFactor() const
         {
             return _norm;
@@ -116,28 +149,59 @@ class FFTBlock: public ArrayFireBlock
             this->emitSignal("normalizationFactorChanged", _norm);
         }
 
-        af::array getInputPort0ForFFT()
+        size_t maxFramesPerCall() const
+        {
+            return _maxFramesPerCall;
+        }
+
+        void setMaxFramesPerCall(size_t maxFramesPerCall)
         {
-            const auto elems = _enforceNumBins ? _numBins : this->workInfo().minElements;
+            if(0 == maxFramesPerCall)
+            {
+                throw Pothos::InvalidArgumentException("maxFramesPerCall must be > 0.");
+            }
 
-            auto bufferChunk = this->input(0)->buffer();
-            bufferChunk.length = elems * bufferChunk.dtype.size();
+            _maxFramesPerCall = maxFramesPerCall;
+
+            // The batch shapes changed, so make sure the new ones are ready.
+            if(this->isActive())
+            {
+                this->configArrayFire();
+                this->_warmUpPlans();
+            }
+        }
+
+        // When numBins is enforced, this returns every whole frame available
+        // (up to the cap), one per column, so they can be transformed at once.
+        af::array getInputPort0ForFFT(size_t numFrames)
+        {
+            const auto elems = _enforceNumBins ? (numFrames * _numBins) : this->workInfo().minElements;
 
-            this->input(0)->consume(elems);
-            return Pothos::Object(bufferChunk).convert<af::array>();
+            auto afInput = this->consumeInputPortAsAfArray(0, elems);
+            return _enforceNumBins ? af::moddims(afInput, static_cast<dim_t>(_numBins), static_cast<dim_t>(numFrames))
+                                   : afInput;
         }
 
         void work() override
         {
             auto elems = this->workInfo().minElements;
-            if(0 == elems)
+            size_t numFrames = _enforceNumBins ? std::min(elems / _numBins, _maxFramesPerCall) : 1;
+            if((0 == elems) || (0 == numFrames))
             {
                 return;
             }
+            numFrames = floorPowerOfTwo(numFrames);
 
-            auto afInput = this->getInputPort0ForFFT();
+            this->configArrayFire();
+
+            // The transform is along the first dimension, so each column is
+            // its own FFT. Flattening keeps the frames in order for a single
+            // output transfer. Batches are rounded down to a power of two, so
+            // there are few enough shapes for all of their plans to be warmed
+            // up and cached.
+            auto afInput = this->getInputPort0ForFFT(numFrames);
             auto afOutput = _func(afInput, this->_norm);
-            this->produceFromAfArray(0, afOutput);
+            this->produceFromAfArray(0, af::flat(afOutput));
         }
 
     private:
@@ -145,7 +209,57 @@ class FFTBlock: public ArrayFireBlock
         bool _enforceNumBins;
         size_t _numBins;
         double _norm;
+        size_t _maxFramesPerCall;
         size_t _nchans;
+
+        FFTPlanReservation _planReservation;
+
+        // Every batch size work() can use, from 1 to the cap
+        std::vector<size_t> _getBatchSizes() const
+        {
+            std::vector<size_t> batchSizes;
+            for(size_t numFrames = 1; numFrames <= _maxFramesPerCall; numFrames <<= 1)
+            {
+                batchSizes.emplace_back(numFrames);
+            }
+
+            return batchSizes;
+        }
+
+        // Creating a plan is far slower than using one, so create them all
+        // here instead of in the first work() calls. Inverse FFTs take
+        // whatever is given, so their shapes aren't known ahead of time.
+        void _warmUpPlans()
+        {
+            if(!_enforceNumBins) return;
+
+            static const Pothos::DType inDType(typeid(InType));
+            static const Pothos::DType outDType(typeid(OutType));
+            const auto afInDType = Pothos::Object(inDType).convert<af::dtype>();
+            const auto afOutDType = Pothos::Object(outDType).convert<af::dtype>();
+
+            const auto batchSizes = this->_getBatchSizes();
+
+            std::vector<FFTPlanKey> planKeys;
+            for(size_t numFrames: batchSizes)
+            {
+                planKeys.emplace_back(FFTPlanKey{
+                    afInDType,
+                    afOutDType,
+                    static_cast<dim_t>(_numBins),
+                    static_cast<dim_t>(numFrames)});
+            }
+            _planReservation.reserve(_afBackend, _afDevice, planKeys);
+
+            for(size_t numFrames: batchSizes)
+            {
+                auto afOutput = _func(
+                                    af::constant(0, static_cast<dim_t>(_numBins), static_cast<dim_t>(numFrames), afInDType),
+                                    _norm);
+                afOutput.eval();
+            }
+            af::sync();
+        }
 };
 
 //
@@ -173,7 +287,7 @@ static EnableIfBothComplex<FwdIn, FwdOut, FFTFunc> getFFTFunc(
 
     auto retLambda = [func](const af::array& arr, const double norm)
                      {
-                         return func(arr, norm, arr.elements());
+                         return func(arr, norm, arr.dims(0));
                      };
 
     return FFTFunc(retLambda);
@@ -273,11 +387,20 @@ static Pothos::Block* makeFFT(
  *
  * Calculates the FFT of the input stream, with an optional normalization factor.
  *
+ * For forward FFTs, all whole frames available are transformed in a single
+ * batched call, up to <b>maxFramesPerCall</b> frames, to keep the device busy
+ * at high sample rates. Lower this value to reduce latency. Batches are rounded
+ * down to a power of two, and the FFT plans for each of these sizes are created
+ * when the block is activated, so that cost isn't paid while streaming. Their
+ * cache can be made larger by calling the <b>/gpu/fft/set_plan_cache_size</b>
+ * plugin.
+ *
  * |category /GPU/Signal
  * |category /FFT/GPU
  * |keywords array signal fft ifft fourier
  * |factory /gpu/signal/fft(device,inputDType,outputDType,numBins,norm,inverse)
  * |setter setNormalizationFactor(norm)
+ * |setter setMaxFramesPerCall(maxFramesPerCall)
  *
  * |param device[Device] Device to use for processing.
  * |default "Auto"
@@ -323,6 +446,11 @@ static Pothos::Block* makeFFT(
  * |widget ToggleSwitch(on="True",off="False")
  * |preview enable
  * |default false
+ *
+ * |param maxFramesPerCall[Max Frames Per Call] The most FFT frames to transform at once.
+ * |widget SpinBox(minimum=1)
+ * |default 64
+ * |preview disable
  */
 static Pothos::BlockRegistry registerFFT(
     fftBlockPath,
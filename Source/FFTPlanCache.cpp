@@ -0,0 +1,195 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "ArrayFireContext.hpp"
+#include "FFTPlanCache.hpp"
+
+#include <Pothos/Exception.hpp>
+#include <Pothos/Plugin.hpp>
+
+#include <arrayfire.h>
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <utility>
+
+// ArrayFire's default
+static constexpr size_t DefaultMinFFTPlanCacheSize = 5;
+
+using DeviceKey = std::pair<af::Backend, int>;
+
+// The number of blocks reserving each plan
+using DevicePlans = std::map<FFTPlanKey, size_t>;
+
+static std::mutex fftPlanCacheMutex;
+static std::map<DeviceKey, DevicePlans> reservedFFTPlans;
+static size_t minFFTPlanCacheSize = DefaultMinFFTPlanCacheSize;
+
+bool FFTPlanKey::operator<(const FFTPlanKey& other) const
+{
+    return std::tie(inputType, outputType, length, batchSize) <
+           std::tie(other.inputType, other.outputType, other.length, other.batchSize);
+}
+
+FFTPlanKey getC2CFFTPlanKey(
+    af::dtype type,
+    size_t length,
+    size_t batchSize)
+{
+    af::dtype complexType = type;
+    if(::f32 == type)      complexType = ::c32;
+    else if(::f64 == type) complexType = ::c64;
+
+    return FFTPlanKey{
+        complexType,
+        complexType,
+        static_cast<dim_t>(length),
+        static_cast<dim_t>(batchSize)};
+}
+
+// Assumes the mutex is held. Each device's cache can only be sized with it
+// active, so switch back to the caller's device afterwards.
+static void applyFFTPlanCacheSize(const DeviceKey& deviceKey)
+{
+    auto iter = reservedFFTPlans.find(deviceKey);
+    const size_t numReserved = (reservedFFTPlans.end() != iter) ? iter->second.size() : 0;
+
+    const auto callerBackend = af::getActiveBackend();
+    const int callerDevice = af::getDevice();
+
+    setThreadArrayFireContext(deviceKey.first, deviceKey.second);
+    af::setFFTPlanCacheSize(std::max(minFFTPlanCacheSize, numReserved));
+    setThreadArrayFireContext(callerBackend, callerDevice);
+}
+
+// Assumes the mutex is held.
+static void releaseFFTPlans(
+    const DeviceKey& deviceKey,
+    const std::vector<FFTPlanKey>& planKeys)
+{
+    auto& devicePlans = reservedFFTPlans[deviceKey];
+    for(const auto& planKey: planKeys)
+    {
+        auto iter = devicePlans.find(planKey);
+        if((devicePlans.end() != iter) && (0 == --iter->second))
+        {
+            devicePlans.erase(iter);
+        }
+    }
+
+    if(devicePlans.empty()) reservedFFTPlans.erase(deviceKey);
+}
+
+//
+// FFTPlanReservation
+//
+
+FFTPlanReservation::FFTPlanReservation():
+    _backend(::AF_BACKEND_DEFAULT),
+    _device(-1)
+{
+}
+
+FFTPlanReservation::~FFTPlanReservation()
+{
+    try
+    {
+        this->release();
+    }
+    catch(...){}
+}
+
+void FFTPlanReservation::reserve(
+    af::Backend backend,
+    int device,
+    const std::vector<FFTPlanKey>& planKeys)
+{
+    std::lock_guard<std::mutex> lock(fftPlanCacheMutex);
+
+    // Release and reserve together so the cache is only resized once.
+    const DeviceKey oldDeviceKey(_backend, _device);
+    if(!_planKeys.empty()) releaseFFTPlans(oldDeviceKey, _planKeys);
+
+    const DeviceKey deviceKey(backend, device);
+    auto& devicePlans = reservedFFTPlans[deviceKey];
+    for(const auto& planKey: planKeys) ++devicePlans[planKey];
+    if(devicePlans.empty()) reservedFFTPlans.erase(deviceKey);
+
+    if(!_planKeys.empty() && (oldDeviceKey != deviceKey))
+    {
+        applyFFTPlanCacheSize(oldDeviceKey);
+    }
+    applyFFTPlanCacheSize(deviceKey);
+
+    _backend = backend;
+    _device = device;
+    _planKeys = planKeys;
+}
+
+void FFTPlanReservation::release()
+{
+    if(_planKeys.empty()) return;
+
+    std::lock_guard<std::mutex> lock(fftPlanCacheMutex);
+
+    const DeviceKey deviceKey(_backend, _device);
+    releaseFFTPlans(deviceKey, _planKeys);
+    applyFFTPlanCacheSize(deviceKey);
+
+    _planKeys.clear();
+}
+
+//
+// Module-wide settings
+//
+
+size_t getMinFFTPlanCacheSize()
+{
+    std::lock_guard<std::mutex> lock(fftPlanCacheMutex);
+
+    return minFFTPlanCacheSize;
+}
+
+void setMinFFTPlanCacheSize(size_t cacheSize)
+{
+    if(0 == cacheSize)
+    {
+        throw Pothos::InvalidArgumentException("The FFT plan cache size must be > 0.");
+    }
+
+    std::lock_guard<std::mutex> lock(fftPlanCacheMutex);
+
+    minFFTPlanCacheSize = cacheSize;
+
+    const DeviceKey callerDeviceKey(af::getActiveBackend(), af::getDevice());
+    if(0 == reservedFFTPlans.count(callerDeviceKey))
+    {
+        applyFFTPlanCacheSize(callerDeviceKey);
+    }
+    for(const auto& reservedPair: reservedFFTPlans)
+    {
+        applyFFTPlanCacheSize(reservedPair.first);
+    }
+}
+
+size_t getNumReservedFFTPlanCacheEntries()
+{
+    std::lock_guard<std::mutex> lock(fftPlanCacheMutex);
+
+    size_t numReserved = 0;
+    for(const auto& reservedPair: reservedFFTPlans) numReserved += reservedPair.second.size();
+
+    return numReserved;
+}
+
+pothos_static_block(registerFFTPlanCache)
+{
+    Pothos::PluginRegistry::addCall(
+        "/gpu/fft/plan_cache_size", &getMinFFTPlanCacheSize);
+    Pothos::PluginRegistry::addCall(
+        "/gpu/fft/set_plan_cache_size", &setMinFFTPlanCacheSize);
+    Pothos::PluginRegistry::addCall(
+        "/gpu/fft/num_reserved_plan_cache_entries", &getNumReservedFFTPlanCacheEntries);
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <arrayfire.h>
+
+#include <cstddef>
+#include <vector>
+
+//
+// FFT plan cache sizing
+//
+// ArrayFire caches FFT plans per device, keyed by shape, so blocks on the
+// same device with the same shapes already share plans. However, the cache
+// only holds a few plans by default, so blocks with different shapes evict
+// each other's plans and pay for plan creation mid-stream. Blocks reserve
+// the plans they use while active, and each device's cache is sized to fit
+// every distinct plan reserved on it, or the module-wide minimum, whichever
+// is larger.
+//
+
+struct FFTPlanKey
+{
+    af::dtype inputType;
+    af::dtype outputType;
+    dim_t length;
+
+    // Blocks whose batch size depends on the input use the batch size of a
+    // full call, or 0 if there isn't one.
+    dim_t batchSize;
+
+    bool operator<(const FFTPlanKey& other) const;
+};
+
+// For complex-to-complex transforms, including af::fft() of a real array,
+// which ArrayFire converts to complex first.
+FFTPlanKey getC2CFFTPlanKey(
+    af::dtype type,
+    size_t length,
+    size_t batchSize);
+
+// Holds one block's reservations on its device. Reserving again replaces
+// the previous reservations, and anything still reserved is released on
+// destruction.
+class FFTPlanReservation
+{
+    public:
+        FFTPlanReservation();
+
+        FFTPlanReservation(const FFTPlanReservation&) = delete;
+        FFTPlanReservation& operator=(const FFTPlanReservation&) = delete;
+
+        virtual ~FFTPlanReservation();
+
+        void reserve(
+            af::Backend backend,
+            int device,
+            const std::vector<FFTPlanKey>& planKeys);
+
+        void release();
+
+    private:
+        af::Backend _backend;
+        int _device;
+        std::vector<FFTPlanKey> _planKeys;
+};
+
+size_t getMinFFTPlanCacheSize();
+
+// Applied immediately to the calling thread's device and every device with
+// reserved plans, and to other devices when a block reserves plans on them.
+void setMinFFTPlanCacheSize(size_t cacheSize);
+
+// Distinct plans, across all devices
+size_t getNumReservedFFTPlanCacheEntries();
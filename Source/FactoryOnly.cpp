@@ -98,7 +98,8 @@ static Pothos::BlockRegistry registerSetUnion(
     Pothos::Callable(&NToOneBlock::makeCallable)
         .bind(Pothos::Callable(af::setUnion).bind(false, 2), 1)
         .bind<DTypeSupport>({true,true,true,false}, 4)
-        .bind<bool>(true, 5));
+        .bind<bool>(true, 5)
+        .bind<bool>(true, 6));
 
 static Pothos::BlockRegistry registerFlip(
     "/gpu/data/flip",
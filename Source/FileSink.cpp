@@ -126,9 +126,11 @@ class FileSinkBlock: public ArrayFireBlock
                 }
             }
 
+            // We accumulate buffers on the host, so don't accept
+            // device-resident buffers.
             for(size_t chan = 0; chan < _nchans; ++chan)
             {
-                this->setupInput(chan, dtype, _domain);
+                this->setupInput(chan, dtype);
             }
 
             _buffers.resize(_nchans);
@@ -152,6 +152,8 @@ class FileSourceBlock: public ArrayFireBlock
                 return;
             }
 
+            this->configArrayFire();
+
             const auto elemsBytes = elems * this->output(0)->dtype().size();
             size_t memcpySize = 0;
             size_t actualElems = 0;
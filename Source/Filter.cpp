@@ -1,7 +1,9 @@
 // Copyright (c) 2019-2021,2023 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include "FFTPlanCache.hpp"
 #include "OneToOneBlock.hpp"
+#include "SignalUtility.hpp"
 #include "Utility.hpp"
 
 #include <Pothos/Exception.hpp>
@@ -13,8 +15,147 @@
 
 #include <arrayfire.h>
 
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <utility>
 #include <vector>
 
+//
+// Overlap-save
+//
+
+// Tap counts at or above this are filtered with FFT-based overlap-save
+// instead of af::fir, whose cost grows with the number of taps per sample.
+// This is only used until the block is activated, when the crossover is
+// measured on the block's device.
+static constexpr size_t DefaultOverlapSaveThreshold = 64;
+
+// Each FFT produces (fftSize - numTaps + 1) outputs, so make it large enough
+// that most of each transform is kept.
+static size_t getOverlapSaveFFTSize(size_t numTaps)
+{
+    return nextPowerOfTwo(4 * numTaps);
+}
+
+// Filters a signal starting with (numTaps-1) samples of history, given the
+// taps' spectrum at the FFT size.
+static af::array overlapSave(
+    const af::array& afSignal,
+    const af::array& afTapsFFT,
+    size_t numTaps,
+    size_t numOutputs)
+{
+    const size_t fftSize = afTapsFFT.elements();
+    const size_t overlap = numTaps - 1;
+    const size_t hopSize = fftSize - overlap;
+    const size_t numFrames = (numOutputs + hopSize - 1) / hopSize;
+    const size_t paddedLength = (numFrames * hopSize) + overlap;
+
+    auto afPaddedSignal = afSignal;
+    if(paddedLength > afSignal.elements())
+    {
+        afPaddedSignal = af::join(
+                             0,
+                             afSignal,
+                             af::constant(
+                                 0,
+                                 static_cast<dim_t>(paddedLength - afSignal.elements()),
+                                 afSignal.type()));
+    }
+
+    // All frames are transformed in one batch, and the first (numTaps-1)
+    // outputs of each, which wrapped around, are dropped.
+    auto afFrames = getOverlappedFrames(afPaddedSignal, fftSize, hopSize, numFrames);
+    auto afFiltered = af::ifft(
+                          af::fft(afFrames) *
+                          af::tile(afTapsFFT, 1, static_cast<unsigned>(numFrames)));
+
+    af::array afOutput = af::flat(afFiltered(af::seq(overlap, fftSize-1), af::span));
+    afOutput = afOutput(af::seq(0, numOutputs-1));
+    if(!afSignal.iscomplex()) afOutput = af::real(afOutput);
+
+    return afOutput;
+}
+
+// Returns the smallest power-of-two tap count overlap-save is faster than
+// af::fir for, at both a small and a large chunk size.
+static size_t measureOverlapSaveThreshold(af::dtype afDType)
+{
+    static constexpr size_t MinTaps = 8;
+    static constexpr size_t MaxTaps = 1024;
+    static constexpr size_t NumIterations = 10;
+    static const std::vector<size_t> ChunkElements = {1 << 12, 1 << 16};
+
+    // af::timeit() only takes plain function pointers, so time the
+    // iterations directly, synchronizing so queued work is counted.
+    auto getTime = [](const std::function<af::array()>& filter)
+    {
+        // Don't count JIT compilation or FFT plan creation.
+        filter().eval();
+        af::sync();
+
+        const auto timer = af::timer::start();
+        for(size_t i = 0; i < NumIterations; ++i) filter().eval();
+        af::sync();
+
+        return af::timer::stop(timer);
+    };
+
+    for(size_t numTaps = MinTaps; numTaps <= MaxTaps; numTaps *= 2)
+    {
+        const auto afTaps = af::randu(static_cast<dim_t>(numTaps), afDType);
+        const auto afTapsFFT = af::fft(afTaps, static_cast<dim_t>(getOverlapSaveFFTSize(numTaps)));
+
+        bool isOverlapSaveFaster = true;
+        for(size_t chunkElements: ChunkElements)
+        {
+            // As work() sees it, with the history prepended
+            const auto afSignal = af::randu(static_cast<dim_t>(chunkElements + numTaps - 1), afDType);
+
+            const double firTime = getTime([&](){return af::fir(afTaps, afSignal);});
+            const double overlapSaveTime = getTime([&](){return overlapSave(afSignal, afTapsFFT, numTaps, chunkElements);});
+
+            isOverlapSaveFaster &= (overlapSaveTime < firTime);
+        }
+
+        if(isOverlapSaveFaster) return numTaps;
+    }
+
+    return 2 * MaxTaps;
+}
+
+// Measuring takes a while, so only do it once per device and type.
+static size_t getOverlapSaveThreshold(
+    af::Backend backend,
+    int device,
+    af::dtype afDType)
+{
+    using DeviceKey = std::pair<af::Backend, int>;
+
+    static std::mutex thresholdsMutex;
+    static std::map<DeviceKey, std::map<af::dtype, size_t>> thresholds;
+
+    const DeviceKey deviceKey(backend, device);
+    {
+        std::lock_guard<std::mutex> lock(thresholdsMutex);
+
+        const auto& deviceThresholds = thresholds[deviceKey];
+        auto iter = deviceThresholds.find(afDType);
+        if(deviceThresholds.end() != iter) return iter->second;
+    }
+
+    // Don't hold the lock while measuring. If another block measures the
+    // same thing at once, either result is fine.
+    const size_t threshold = measureOverlapSaveThreshold(afDType);
+
+    std::lock_guard<std::mutex> lock(thresholdsMutex);
+    thresholds[deviceKey][afDType] = threshold;
+
+    return threshold;
+}
+
 //
 // Block classes
 //
@@ -35,16 +176,23 @@ class FIRBlock: public OneToOneBlock
         ):
             OneToOneBlock(
                 device,
-                Pothos::Callable(&af::fir),
+                Pothos::Callable(),
                 Pothos::DType::fromDType(Class::dtype, dtypeDims),
                 Pothos::DType::fromDType(Class::dtype, dtypeDims)),
-            _taps({T(1.0)}),
             _waitTaps(false),
-            _waitTapsArmed(false)
+            _waitTapsArmed(false),
+            _overlapSaveThreshold(DefaultOverlapSaveThreshold),
+            _calibrateOverlapSave(true),
+            _fftSize(0)
         {
+            this->setTaps({TapType(1.0)});
+
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, taps));
             this->registerCall(this, POTHOS_FCN_TUPLE(Class, setTaps));
             this->registerCall(this, POTHOS_FCN_TUPLE(Class, waitTaps));
             this->registerCall(this, POTHOS_FCN_TUPLE(Class, setWaitTaps));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, overlapSaveThreshold));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, setOverlapSaveThreshold));
         }
 
         virtual ~FIRBlock() = default;
@@ -53,7 +201,25 @@ class FIRBlock: public OneToOneBlock
         {
             ArrayFireBlock::activate();
 
+            if(_calibrateOverlapSave)
+            {
+                _overlapSaveThreshold = getOverlapSaveThreshold(
+                                            _afBackend,
+                                            _afDevice,
+                                            Pothos::Object(Class::dtype).convert<af::dtype>());
+                this->_updateOverlapSave();
+            }
+
             _waitTapsArmed = _waitTaps;
+            this->_resetHistory();
+            this->_reservePlans();
+        }
+
+        void deactivate() override
+        {
+            OneToOneBlock::deactivate();
+
+            _planReservation.release();
         }
 
         std::vector<TapType> taps() const
@@ -68,9 +234,16 @@ class FIRBlock: public OneToOneBlock
                 throw Pothos::InvalidArgumentException("Taps cannot be empty.");
             }
 
+            this->configArrayFire();
+
+            const bool numTapsChanged = (taps.size() != _taps.size());
+
             _taps = taps;
-            _func.bind(Pothos::Object(_taps).convert<af::array>(), 0);
+            _afTaps = Pothos::Object(_taps).convert<af::array>();
+            this->_updateOverlapSave();
             _waitTapsArmed = false; // We have taps
+
+            if(numTapsChanged) this->_resetHistory();
         }
 
         bool waitTaps() const
@@ -83,25 +256,147 @@ class FIRBlock: public OneToOneBlock
             _waitTaps = waitTaps;
         }
 
+        size_t overlapSaveThreshold() const
+        {
+            return _overlapSaveThreshold;
+        }
+
+        // 0 measures the threshold on the device instead, which is the
+        // default.
+        void setOverlapSaveThreshold(size_t overlapSaveThreshold)
+        {
+            this->configArrayFire();
+
+            _calibrateOverlapSave = (0 == overlapSaveThreshold);
+            if(!_calibrateOverlapSave)
+            {
+                _overlapSaveThreshold = overlapSaveThreshold;
+            }
+            else if(this->isActive())
+            {
+                _overlapSaveThreshold = getOverlapSaveThreshold(
+                                            _afBackend,
+                                            _afDevice,
+                                            Pothos::Object(Class::dtype).convert<af::dtype>());
+            }
+            else _overlapSaveThreshold = DefaultOverlapSaveThreshold;
+
+            this->_updateOverlapSave();
+        }
+
         void work() override
         {
             // If specified, don't do anything until taps are explicitly set.
             if(_waitTapsArmed) return;
 
-            OneToOneBlock::work();
+            // The thread may have changed since the block was created, so make sure
+            // the backend and device still match.
+            this->configArrayFire();
+
+            const size_t elems = this->getBatchElements(this->workInfo().minElements);
+            if(0 == elems)
+            {
+                this->flushPipelinedOutputs();
+                return;
+            }
+
+            auto afInput = this->getInputPortAsAfArray(0);
+            this->produceFromAfArray(0, this->_filter(afInput));
         }
 
     private:
         std::vector<TapType> _taps;
         bool _waitTaps;
         bool _waitTapsArmed;
+
+        af::array _afTaps;
+
+        // The last (numTaps-1) input samples, kept on the device so each
+        // chunk is filtered as a continuation of the previous one.
+        af::array _afHistory;
+
+        // Only used when the number of taps is at least the threshold.
+        // Unless the threshold is set explicitly, it's measured the first
+        // time a block with the same type and device is activated.
+        size_t _overlapSaveThreshold;
+        bool _calibrateOverlapSave;
+        size_t _fftSize;
+        af::array _afTapsFFT;
+
+        FFTPlanReservation _planReservation;
+
+        // The taps' transform, and the frames' forward and inverse
+        // transforms, whose batch size depends on the input
+        void _reservePlans()
+        {
+            if(0 == _fftSize)
+            {
+                _planReservation.release();
+                return;
+            }
+
+            const auto afDType = Pothos::Object(Class::dtype).convert<af::dtype>();
+            _planReservation.reserve(
+                _afBackend,
+                _afDevice,
+                {getC2CFFTPlanKey(afDType, _fftSize, 1),
+                 getC2CFFTPlanKey(afDType, _fftSize, 0)});
+        }
+
+        void _resetHistory()
+        {
+            if(_taps.size() > 1)
+            {
+                _afHistory = af::constant(
+                                 0,
+                                 static_cast<dim_t>(_taps.size()-1),
+                                 Pothos::Object(Class::dtype).convert<af::dtype>());
+            }
+            else _afHistory = af::array();
+        }
+
+        void _updateOverlapSave()
+        {
+            if(_taps.size() >= _overlapSaveThreshold)
+            {
+                _fftSize = getOverlapSaveFFTSize(_taps.size());
+                _afTapsFFT = af::fft(_afTaps, static_cast<dim_t>(_fftSize));
+            }
+            else
+            {
+                _fftSize = 0;
+                _afTapsFFT = af::array();
+            }
+
+            if(this->isActive()) this->_reservePlans();
+        }
+
+        af::array _filter(const af::array& afInput)
+        {
+            if(_afHistory.isempty()) return af::fir(_afTaps, afInput);
+
+            const size_t numInputs = afInput.elements();
+            const size_t numHistory = _afHistory.elements();
+
+            auto afSignal = af::join(0, _afHistory, afInput);
+            const size_t signalLength = afSignal.elements();
+
+            af::array afOutput;
+            if(_fftSize > 0) afOutput = overlapSave(afSignal, _afTapsFFT, _taps.size(), numInputs);
+            else afOutput = af::fir(_afTaps, afSignal)(af::seq(numHistory, signalLength-1));
+
+            _afHistory = afSignal(af::seq(signalLength-numHistory, signalLength-1));
+            _afHistory.eval();
+
+            return afOutput;
+        }
 };
 
 template <typename T>
 const Pothos::DType FIRBlock<T>::dtype(typeid(T));
 
 template <typename T>
-class IIRBlock: public OneToOneBlock
+class IIRBlock: public ArrayFireBlock
 {
     public:
         using Type = T;
@@ -116,23 +411,37 @@ class IIRBlock: public OneToOneBlock
 
         IIRBlock(
             const std::string& device,
-            size_t dtypeDims
+            size_t dtypeDims,
+            size_t numChannels
         ):
-            OneToOneBlock(
-                device,
-                Pothos::Callable(&af::iir),
-                Pothos::DType::fromDType(Class::dtype, dtypeDims),
-                Pothos::DType::fromDType(Class::dtype, dtypeDims)),
+            ArrayFireBlock(device),
             _feedForwardCoeffs({0.0676, 0.135, 0.0676}),
             _feedbackCoeffs({1, -1.142, 0.412}),
             _waitTaps(false),
-            _waitTapsArmed(false)
+            _waitTapsArmed(false),
+            _numChannels(numChannels),
+            _order(0)
         {
+            if(0 == numChannels)
+            {
+                throw Pothos::InvalidArgumentException("numChannels must be > 0.");
+            }
+
+            for(size_t chan = 0; chan < _numChannels; ++chan)
+            {
+                this->setupInput(chan, Pothos::DType::fromDType(Class::dtype, dtypeDims), _domain);
+                this->setupOutput(chan, Pothos::DType::fromDType(Class::dtype, dtypeDims), _domain);
+            }
+
+            this->_updateCoeffs();
+
             this->registerCall(this, POTHOS_FCN_TUPLE(Class, waitTaps));
             this->registerCall(this, POTHOS_FCN_TUPLE(Class, setWaitTaps));
             this->registerCall(this, POTHOS_FCN_TUPLE(Class, setFeedForwardCoeffs));
             this->registerCall(this, POTHOS_FCN_TUPLE(Class, setFeedbackCoeffs));
             this->registerCall(this, POTHOS_FCN_TUPLE(Class, setTapsFromCommsIIRDesigner));
+            this->registerPipeliningCalls();
+            this->registerBatchingCalls();
         }
 
         virtual ~IIRBlock() = default;
@@ -142,6 +451,7 @@ class IIRBlock: public OneToOneBlock
             ArrayFireBlock::activate();
 
             _waitTapsArmed = _waitTaps;
+            this->_resetState();
         }
 
         void setFeedForwardCoeffs(const std::vector<TapType>& feedForwardCoeffs)
@@ -161,7 +471,7 @@ class IIRBlock: public OneToOneBlock
             }
 
             _feedForwardCoeffs = feedForwardCoeffs;
-            _func.bind(Pothos::Object(_feedForwardCoeffs).convert<af::array>(), 0);
+            this->_updateCoeffs();
             _disarmWaitTapsIfCoeffsPopulated();
         }
 
@@ -177,9 +487,13 @@ class IIRBlock: public OneToOneBlock
                           "Feed-forward and feedback coefficients "
                           "must be the same size.");
             }
+            else if(TapType(0) == feedbackCoeffs[0])
+            {
+                throw Pothos::InvalidArgumentException("The first feedback coefficient cannot be 0.");
+            }
 
             _feedbackCoeffs = feedbackCoeffs;
-            _func.bind(Pothos::Object(_feedbackCoeffs).convert<af::array>(), 1);
+            this->_updateCoeffs();
             _disarmWaitTapsIfCoeffsPopulated();
         }
 
@@ -229,7 +543,26 @@ class IIRBlock: public OneToOneBlock
             // If specified, don't do anything until taps are explicitly set.
             if(_waitTapsArmed) return;
 
-            OneToOneBlock::work();
+            // The thread may have changed since the block was created, so make sure
+            // the backend and device still match.
+            this->configArrayFire();
+
+            const size_t elems = this->getBatchElements(this->workInfo().minElements);
+            if(0 == elems)
+            {
+                this->flushPipelinedOutputs();
+                return;
+            }
+
+            // Each channel is a column, so all channels are filtered in a
+            // single af::iir call.
+            std::vector<af::array> afInputs;
+            for(size_t chan = 0; chan < _numChannels; ++chan)
+            {
+                afInputs.emplace_back(this->getInputPortAsAfArray(chan));
+            }
+
+            this->produceColumnsFromAfArray(this->_filter(joinAfArrays(1, afInputs)));
         }
 
     private:
@@ -238,10 +571,154 @@ class IIRBlock: public OneToOneBlock
         bool _waitTaps;
         bool _waitTapsArmed;
 
+        size_t _numChannels;
+
+        // Normalized so the first feedback coefficient is 1.
+        af::array _afFeedForwardCoeffs;
+        af::array _afFeedbackCoeffs;
+
+        // [1, 0, ...], for the impulse response of 1/A(z)
+        af::array _afUnitNumerator;
+
+        // The 1/A(z) impulse response only depends on the coefficients, so
+        // it's computed once and sliced for each chunk. It's only
+        // recomputed, to the next power of two, when a chunk is longer.
+        af::array _afImpulseResponse;
+
+        //
+        // af::iir always starts from zero state, so the direct-form II
+        // transposed delay line is carried between calls separately. Its
+        // contents are a linear function of the last (order) inputs and
+        // outputs, which are kept on the device with the most recent first,
+        // one column per channel. Its effect on the next chunk is its
+        // zero-input response, which is added to af::iir's output.
+        //
+        size_t _order;
+        af::array _afInputStateMatrix;
+        af::array _afOutputStateMatrix;
+        af::array _afInputHistory;
+        af::array _afOutputHistory;
+
         inline void _disarmWaitTapsIfCoeffsPopulated()
         {
             _waitTapsArmed = _feedForwardCoeffs.empty() || _feedbackCoeffs.empty();
         }
+
+        // The delay line element i is the sum over j > i of
+        // (b[j] * x[n-(j-i-1)]) - (a[j] * y[n-(j-i-1)]).
+        af::array _getStateMatrix(const std::vector<TapType>& normalizedCoeffs) const
+        {
+            std::vector<TapType> stateMatrix(_order * _order, TapType(0));
+            for(size_t i = 0; i < _order; ++i)
+            {
+                for(size_t m = 0; (i+1+m) < normalizedCoeffs.size(); ++m)
+                {
+                    // Column-major, to match ArrayFire
+                    stateMatrix[i + (m * _order)] = normalizedCoeffs[i+1+m];
+                }
+            }
+
+            return af::moddims(
+                       Pothos::Object(stateMatrix).convert<af::array>(),
+                       static_cast<dim_t>(_order),
+                       static_cast<dim_t>(_order));
+        }
+
+        void _updateCoeffs()
+        {
+            this->configArrayFire();
+
+            const size_t numCoeffs = std::max(_feedForwardCoeffs.size(), _feedbackCoeffs.size());
+            const size_t order = numCoeffs - 1;
+
+            auto feedForwardCoeffs = _feedForwardCoeffs;
+            auto feedbackCoeffs = _feedbackCoeffs;
+            feedForwardCoeffs.resize(numCoeffs, TapType(0));
+            feedbackCoeffs.resize(numCoeffs, TapType(0));
+
+            const TapType a0 = feedbackCoeffs[0];
+            for(auto& coeff: feedForwardCoeffs) coeff /= a0;
+            for(auto& coeff: feedbackCoeffs) coeff /= a0;
+
+            _afFeedForwardCoeffs = Pothos::Object(feedForwardCoeffs).convert<af::array>();
+            _afFeedbackCoeffs = Pothos::Object(feedbackCoeffs).convert<af::array>();
+
+            std::vector<TapType> unitNumerator(numCoeffs, TapType(0));
+            unitNumerator[0] = TapType(1);
+            _afUnitNumerator = Pothos::Object(unitNumerator).convert<af::array>();
+            _afImpulseResponse = af::array();
+
+            const bool orderChanged = (order != _order);
+            _order = order;
+            if(_order > 0)
+            {
+                _afInputStateMatrix = this->_getStateMatrix(feedForwardCoeffs);
+                _afOutputStateMatrix = this->_getStateMatrix(feedbackCoeffs);
+            }
+
+            if(orderChanged) this->_resetState();
+        }
+
+        void _resetState()
+        {
+            if(_order > 0)
+            {
+                const auto afDType = Pothos::Object(Class::dtype).convert<af::dtype>();
+
+                _afInputHistory = af::constant(
+                                      0,
+                                      static_cast<dim_t>(_order),
+                                      static_cast<dim_t>(_numChannels),
+                                      afDType);
+                _afOutputHistory = _afInputHistory.copy();
+            }
+            else
+            {
+                _afInputHistory = af::array();
+                _afOutputHistory = af::array();
+            }
+        }
+
+        af::array _getImpulseResponse(size_t numElements)
+        {
+            if(static_cast<size_t>(_afImpulseResponse.elements()) < numElements)
+            {
+                const auto impulseLength = static_cast<dim_t>(nextPowerOfTwo(numElements));
+
+                auto afImpulse = af::constant(0, impulseLength, _afFeedbackCoeffs.type());
+                afImpulse(0) = 1;
+                _afImpulseResponse = af::iir(_afUnitNumerator, _afFeedbackCoeffs, afImpulse);
+                _afImpulseResponse.eval();
+            }
+
+            return _afImpulseResponse(af::seq(0, static_cast<double>(numElements-1)));
+        }
+
+        af::array _filter(const af::array& afInput)
+        {
+            auto afOutput = af::iir(_afFeedForwardCoeffs, _afFeedbackCoeffs, afInput);
+            if(0 == _order) return afOutput;
+
+            const auto numElements = afInput.dims(0);
+
+            // The delay line's contribution is the 1/A(z) impulse response
+            // convolved with its contents.
+            auto afDelayLine = af::matmul(_afInputStateMatrix, _afInputHistory) -
+                               af::matmul(_afOutputStateMatrix, _afOutputHistory);
+
+            const auto afImpulseResponse = this->_getImpulseResponse(static_cast<size_t>(numElements));
+
+            auto afZeroInputResponse = af::convolve1(afImpulseResponse, afDelayLine, AF_CONV_EXPAND);
+            afOutput += afZeroInputResponse(af::seq(0, static_cast<double>(numElements-1)), af::span);
+
+            // Prepend the new samples, newest first, and keep (order) of them.
+            const auto historySeq = af::seq(0, static_cast<double>(_order-1));
+            _afInputHistory = af::join(0, af::flip(afInput, 0), _afInputHistory)(historySeq, af::span);
+            _afOutputHistory = af::join(0, af::flip(afOutput, 0), _afOutputHistory)(historySeq, af::span);
+            af::eval(_afInputHistory, _afOutputHistory);
+
+            return afOutput;
+        }
 };
 
 template <typename T>
@@ -270,13 +747,14 @@ static Pothos::Block* makeFIR(
               dtype.name());
 }
 
-static Pothos::Block* makeIIR(
+static Pothos::Block* makeMultichannelIIR(
     const std::string& device,
-    const Pothos::DType& dtype)
+    const Pothos::DType& dtype,
+    size_t numChannels)
 {
     #define ifTypeDeclareFactory(T) \
         if(Pothos::DType::fromDType(dtype, 1) == Pothos::DType(typeid(T))) \
-            return new IIRBlock<T>(device,dtype.dimension());
+            return new IIRBlock<T>(device,dtype.dimension(),numChannels);
 
     ifTypeDeclareFactory(float)
     ifTypeDeclareFactory(double)
@@ -289,6 +767,13 @@ static Pothos::Block* makeIIR(
               dtype.name());
 }
 
+static Pothos::Block* makeIIR(
+    const std::string& device,
+    const Pothos::DType& dtype)
+{
+    return makeMultichannelIIR(device, dtype, 1);
+}
+
 //
 // Block registries
 //
@@ -300,12 +785,17 @@ static Pothos::Block* makeIIR(
  * taps. The taps can be set at runtime by connecting the output of a FIR Designer
  * block to <b>"setTaps"</b>.
  *
+ * The filter's history is kept on the device between calls, so the output
+ * doesn't depend on how the input stream is split up. For long filters,
+ * FFT-based overlap-save is used instead of <b>af::fir</b>.
+ *
  * |category /GPU/Signal
  * |category /Filter/GPU
- * |keywords array tap taps fir
+ * |keywords array tap taps fir overlap save
  * |factory /gpu/signal/fir_filter(device,dtype)
  * |setter setTaps(taps)
  * |setter setWaitTaps(waitTaps)
+ * |setter setOverlapSaveThreshold(overlapSaveThreshold)
  *
  * |param device[Device] Device to use for processing.
  * |default "Auto"
@@ -325,6 +815,13 @@ static Pothos::Block* makeIIR(
  * |widget ToggleSwitch(on="True", off="False")
  * |default false
  * |preview disable
+ *
+ * |param overlapSaveThreshold[Overlap-Save Threshold] The number of taps at which
+ * to filter with FFT-based overlap-save instead of <b>af::fir</b>. If 0, the
+ * crossover is measured on the device when the block is activated.
+ * |widget SpinBox(minimum=0)
+ * |default 0
+ * |preview disable
  */
 static Pothos::BlockRegistry registerFIR(
     "/gpu/signal/fir_filter",
@@ -341,6 +838,10 @@ static Pothos::BlockRegistry registerFIR(
  * can be connected to <b>setTapsFromCommsIIRDesigner</b> to set both sets of
  * coefficients simultaneously.
  *
+ * The filter's state is kept on the device between calls, so the output
+ * doesn't depend on how the input stream is split up. To filter several
+ * channels with the same coefficients, use the multichannel IIR filter.
+ *
  * |category /GPU/Signal
  * |category /Filter/GPU
  * |keywords array tap taps iir
@@ -383,3 +884,66 @@ static Pothos::BlockRegistry registerFIR(
 static Pothos::BlockRegistry registerIIR(
     "/gpu/signal/iir_filter",
     Pothos::Callable(&makeIIR));
+
+/*
+ * |PothosDoc Multichannel IIR Filter (GPU)
+ *
+ * Uses <b>af::iir</b> to convolve the input stream with user-provided filter
+ * taps. The individual coefficient parts can be set at runtime by connecting
+ * the outputs of a designer block to <b>"setFeedForwardCoeffs"</b> and
+ * <b>"setFeedbackCoeffs"</b>. Alternatively, the output of <b>/comms/iir_designer</b>
+ * can be connected to <b>setTapsFromCommsIIRDesigner</b> to set both sets of
+ * coefficients simultaneously.
+ *
+ * The filter's state is kept on the device between calls, so the output
+ * doesn't depend on how the input stream is split up. Each channel has its
+ * own input and output port and its own state, and all channels are filtered
+ * together in a single <b>af::iir</b> call.
+ *
+ * |category /GPU/Signal
+ * |category /Filter/GPU
+ * |keywords array tap taps iir multichannel
+ * |factory /gpu/signal/multichannel_iir_filter(device,dtype,numChannels)
+ * |setter setFeedForwardCoeffs(feedForwardCoeffs)
+ * |setter setFeedbackCoeffs(feedbackCoeffs)
+ * |setter setTapsFromCommsIIRDesigner(taps)
+ * |setter setWaitTaps(waitTaps)
+ *
+ * |param device[Device] Device to use for processing.
+ * |default "Auto"
+ *
+ * |param dtype[Data Type] The output's data type.
+ * |widget DTypeChooser(float=1,cfloat=1,dim=1)
+ * |default "complex_float64"
+ * |preview disable
+ *
+ * |param numChannels[Num Channels] The number of independent channels to filter.
+ * |widget SpinBox(minimum=1)
+ * |default 2
+ * |preview disable
+ *
+ * |param feedForwardCoeffs[Feed-Forward Coefficients]
+ * |widget LineEdit()
+ * |default [0.0676, 0.135, 0.0676]
+ * |preview enable
+ *
+ * |param feedbackCoeffs[Feedback Coefficients]
+ * |widget LineEdit()
+ * |default [1, -1.142, 0.412]
+ * |preview enable
+ *
+ * |param taps[Taps] The combined feed-forward and feedback coefficients.
+ * This parameter is only intended to be used with <b>/comms/iir_designer</b>.
+ * |widget LineEdit()
+ * |default [0.0676, 0.135, 0.0676, 1, -1.142, 0.412]
+ * |preview disable
+ *
+ * |param waitTaps[Wait Taps] Wait for the taps to be set before allowing operation.
+ * Use this mode when taps are set exclusively at runtime by the setTaps() slot.
+ * |widget ToggleSwitch(on="True", off="False")
+ * |default false
+ * |preview disable
+ */
+static Pothos::BlockRegistry registerMultichannelIIR(
+    "/gpu/signal/multichannel_iir_filter",
+    Pothos::Callable(&makeMultichannelIIR));
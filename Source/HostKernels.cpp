@@ -0,0 +1,143 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "HostKernels.hpp"
+
+#include <Pothos/Framework.hpp>
+
+#include <arrayfire.h>
+
+#include <algorithm>
+#include <cmath>
+#include <typeinfo>
+#include <vector>
+
+//
+// Kernels
+//
+
+// Kept to a simple loop over non-aliasing buffers so the compiler can
+// vectorize it.
+template <typename T, typename Op>
+static void hostKernel(const void* input, void* output, size_t numElements)
+{
+    const T* __restrict in = static_cast<const T*>(input);
+    T* __restrict out = static_cast<T*>(output);
+
+    const Op op;
+    for(size_t elem = 0; elem < numElements; ++elem)
+    {
+        out[elem] = op(in[elem]);
+    }
+}
+
+#define DECLARE_HOST_OP(func) \
+    struct HostOp_ ## func \
+    { \
+        template <typename T> \
+        inline T operator()(const T& value) const \
+        { \
+            return std::func(value); \
+        } \
+    };
+
+DECLARE_HOST_OP(abs)
+DECLARE_HOST_OP(sqrt)
+DECLARE_HOST_OP(cbrt)
+DECLARE_HOST_OP(exp)
+DECLARE_HOST_OP(expm1)
+DECLARE_HOST_OP(log)
+DECLARE_HOST_OP(log1p)
+DECLARE_HOST_OP(log10)
+DECLARE_HOST_OP(log2)
+DECLARE_HOST_OP(sin)
+DECLARE_HOST_OP(cos)
+DECLARE_HOST_OP(tan)
+DECLARE_HOST_OP(asin)
+DECLARE_HOST_OP(acos)
+DECLARE_HOST_OP(atan)
+DECLARE_HOST_OP(sinh)
+DECLARE_HOST_OP(cosh)
+DECLARE_HOST_OP(tanh)
+DECLARE_HOST_OP(asinh)
+DECLARE_HOST_OP(acosh)
+DECLARE_HOST_OP(atanh)
+DECLARE_HOST_OP(erf)
+DECLARE_HOST_OP(erfc)
+DECLARE_HOST_OP(tgamma)
+DECLARE_HOST_OP(lgamma)
+DECLARE_HOST_OP(floor)
+DECLARE_HOST_OP(ceil)
+DECLARE_HOST_OP(round)
+DECLARE_HOST_OP(trunc)
+
+//
+// Lookup
+//
+
+using AfOneToOneFunc = af::array(*)(const af::array&);
+
+struct HostKernelEntry
+{
+    AfOneToOneFunc afFunc;
+    OneToOneHostKernel floatKernel;
+    OneToOneHostKernel doubleKernel;
+};
+
+#define HOST_KERNEL_ENTRY(func) \
+    {&af::func, &hostKernel<float, HostOp_ ## func>, &hostKernel<double, HostOp_ ## func>}
+
+OneToOneHostKernel getOneToOneHostKernel(
+    AfOneToOneFunc afFunc,
+    const Pothos::DType& inputDType,
+    const Pothos::DType& outputDType)
+{
+    static const std::vector<HostKernelEntry> HostKernelEntries =
+    {
+        HOST_KERNEL_ENTRY(abs),
+        HOST_KERNEL_ENTRY(sqrt),
+        HOST_KERNEL_ENTRY(cbrt),
+        HOST_KERNEL_ENTRY(exp),
+        HOST_KERNEL_ENTRY(expm1),
+        HOST_KERNEL_ENTRY(log),
+        HOST_KERNEL_ENTRY(log1p),
+        HOST_KERNEL_ENTRY(log10),
+        HOST_KERNEL_ENTRY(log2),
+        HOST_KERNEL_ENTRY(sin),
+        HOST_KERNEL_ENTRY(cos),
+        HOST_KERNEL_ENTRY(tan),
+        HOST_KERNEL_ENTRY(asin),
+        HOST_KERNEL_ENTRY(acos),
+        HOST_KERNEL_ENTRY(atan),
+        HOST_KERNEL_ENTRY(sinh),
+        HOST_KERNEL_ENTRY(cosh),
+        HOST_KERNEL_ENTRY(tanh),
+        HOST_KERNEL_ENTRY(asinh),
+        HOST_KERNEL_ENTRY(acosh),
+        HOST_KERNEL_ENTRY(atanh),
+        HOST_KERNEL_ENTRY(erf),
+        HOST_KERNEL_ENTRY(erfc),
+        HOST_KERNEL_ENTRY(tgamma),
+        HOST_KERNEL_ENTRY(lgamma),
+        HOST_KERNEL_ENTRY(floor),
+        HOST_KERNEL_ENTRY(ceil),
+        HOST_KERNEL_ENTRY(round),
+        HOST_KERNEL_ENTRY(trunc),
+    };
+
+    // ArrayFire may change the output type, which these don't account for.
+    if((inputDType != outputDType) || (inputDType.dimension() != 1)) return nullptr;
+
+    auto entryIter = std::find_if(
+                         HostKernelEntries.begin(),
+                         HostKernelEntries.end(),
+                         [&afFunc](const HostKernelEntry& entry)
+                         {
+                             return (entry.afFunc == afFunc);
+                         });
+    if(HostKernelEntries.end() == entryIter) return nullptr;
+
+    if(inputDType == Pothos::DType(typeid(float))) return entryIter->floatKernel;
+    else if(inputDType == Pothos::DType(typeid(double))) return entryIter->doubleKernel;
+    else return nullptr;
+}
@@ -0,0 +1,27 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <Pothos/Framework.hpp>
+
+#include <arrayfire.h>
+
+#include <cstddef>
+
+//
+// Host equivalents of element-wise ArrayFire functions
+//
+// For small enough chunks, the fixed cost of getting data to and from
+// ArrayFire outweighs the computation itself, so blocks can run these plain
+// loops on the host buffers instead.
+//
+
+using OneToOneHostKernel = void(*)(const void* input, void* output, size_t numElements);
+
+// Returns nullptr if there is no host equivalent for the given function
+// and type.
+OneToOneHostKernel getOneToOneHostKernel(
+    af::array(*afFunc)(const af::array&),
+    const Pothos::DType& inputDType,
+    const Pothos::DType& outputDType);
@@ -51,6 +51,8 @@ class MinMax: public ArrayFireBlock
                 return;
             }
 
+            this->configArrayFire();
+
             af::array val, idx;
 
             auto afInput = this->getInputPortAsAfArray(0);
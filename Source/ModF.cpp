@@ -49,6 +49,8 @@ class ModF: public ArrayFireBlock
                 return;
             }
 
+            this->configArrayFire();
+
             auto afInput = this->getInputPortAsAfArray(0);
             auto afInt = af::trunc(afInput);
             auto afFrac = afInput - afInt;
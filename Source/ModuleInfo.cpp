@@ -1,7 +1,8 @@
-// Copyright (c) 2019 Nicholas Corgan
+// Copyright (c) 2019,2023 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include "DeviceCache.hpp"
+#include "DeviceProfile.hpp"
 #include "Utility.hpp"
 
 #include <Pothos/Plugin.hpp>
@@ -68,7 +69,11 @@ static std::string enumerateArrayFireDevices()
     // Only do this once
     static const std::string devs = _enumerateArrayFireDevices();
 
-    return devs;
+    // The selections change if the devices are profiled later.
+    auto topObject = json::parse(devs);
+    topObject["PothosGPU Auto Device Selection"] = json::parse(getAutoDeviceSelectionsJSON());
+
+    return topObject.dump();
 }
 
 pothos_static_block(registerGPUInfo)
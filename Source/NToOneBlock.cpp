@@ -1,4 +1,4 @@
-// Copyright (c) 2019-2020 Nicholas Corgan
+// Copyright (c) 2019-2020,2023 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include "NToOneBlock.hpp"
@@ -13,6 +13,8 @@
 #include <cassert>
 #include <string>
 #include <typeinfo>
+#include <utility>
+#include <vector>
 
 
 //
@@ -25,7 +27,8 @@ Pothos::Block* NToOneBlock::make(
     const Pothos::DType& dtype,
     size_t numChannels,
     const DTypeSupport& supportedTypes,
-    bool shouldPostBuffer)
+    bool shouldPostBuffer,
+    bool isAssociative)
 {
     validateDType(dtype, supportedTypes);
 
@@ -34,7 +37,8 @@ Pothos::Block* NToOneBlock::make(
                    func,
                    dtype,
                    numChannels,
-                   shouldPostBuffer);
+                   shouldPostBuffer,
+                   isAssociative);
 }
 
 Pothos::Block* NToOneBlock::makeCallable(
@@ -43,7 +47,8 @@ Pothos::Block* NToOneBlock::makeCallable(
     const Pothos::DType& dtype,
     size_t numChannels,
     const DTypeSupport& supportedTypes,
-    bool shouldPostBuffer)
+    bool shouldPostBuffer,
+    bool isAssociative)
 {
     validateDType(dtype, supportedTypes);
 
@@ -52,7 +57,8 @@ Pothos::Block* NToOneBlock::makeCallable(
                    func,
                    dtype,
                    numChannels,
-                   shouldPostBuffer);
+                   shouldPostBuffer,
+                   isAssociative);
 }
 
 //
@@ -64,14 +70,17 @@ NToOneBlock::NToOneBlock(
     const NToOneFunc& func,
     const Pothos::DType& dtype,
     size_t numChannels,
-    bool shouldPostBuffer
+    bool shouldPostBuffer,
+    bool isAssociative
 ): NToOneBlock(
        device,
-       Pothos::Callable(func),
+       Pothos::Callable(),
        dtype,
        numChannels,
-       shouldPostBuffer)
+       shouldPostBuffer,
+       isAssociative)
 {
+    _rawFunc = func;
 }
 
 NToOneBlock::NToOneBlock(
@@ -79,11 +88,14 @@ NToOneBlock::NToOneBlock(
     const Pothos::Callable& func,
     const Pothos::DType& dtype,
     size_t numChannels,
-    bool shouldPostBuffer
+    bool shouldPostBuffer,
+    bool isAssociative
 ): ArrayFireBlock(device),
+   _rawFunc(nullptr),
    _func(func),
    _nchans(0),
-    _postBuffer(shouldPostBuffer)
+   _postBuffer(shouldPostBuffer),
+   _isAssociative(isAssociative)
 {
     if(numChannels < 2)
     {
@@ -96,28 +108,65 @@ NToOneBlock::NToOneBlock(
         this->setupInput(chan, dtype, _domain);
     }
     this->setupOutput(0, dtype, _domain);
+
+    this->registerPipeliningCalls();
+
+    this->registerBatchingCalls();
 }
 
 NToOneBlock::~NToOneBlock() {}
 
 void NToOneBlock::work()
 {
-    const size_t elems = this->workInfo().minAllElements;
+    this->configArrayFire();
+
+    const size_t elems = this->getBatchElements(this->workInfo().minAllElements);
 
     if(0 == elems)
     {
+        this->flushPipelinedOutputs();
         return;
     }
 
-    auto afArray = this->getInputPortAsAfArray(0);
-    auto outputAfArray = afArray;
+    std::vector<af::array> afArrays;
+    for(size_t chan = 0; chan < _nchans; ++chan)
+    {
+        afArrays.emplace_back(this->getInputPortAsAfArray(chan));
+    }
 
-    for(size_t chan = 1; chan < _nchans; ++chan)
+    if(_isAssociative)
     {
-        afArray = this->getInputPortAsAfArray(chan);
-        outputAfArray = _func.call(outputAfArray, afArray).template extract<af::array>();
+        // Each pass halves the number of arrays, with any odd one out
+        // carried over to the next pass.
+        while(afArrays.size() > 1)
+        {
+            std::vector<af::array> combinedAfArrays;
+            for(size_t i = 0; (i+1) < afArrays.size(); i += 2)
+            {
+                combinedAfArrays.emplace_back(this->_combine(afArrays[i], afArrays[i+1]));
+            }
+            if(afArrays.size() % 2) combinedAfArrays.emplace_back(afArrays.back());
+
+            afArrays = std::move(combinedAfArrays);
+        }
+    }
+    else
+    {
+        for(size_t chan = 1; chan < _nchans; ++chan)
+        {
+            afArrays[0] = this->_combine(afArrays[0], afArrays[chan]);
+        }
     }
 
+    const auto& outputAfArray = afArrays[0];
     if(_postBuffer) this->postAfArray(0, outputAfArray);
     else            this->produceFromAfArray(0, outputAfArray);
 }
+
+af::array NToOneBlock::_combine(
+    const af::array& afArray0,
+    const af::array& afArray1) const
+{
+    if(_rawFunc) return _rawFunc(afArray0, afArray1);
+    else         return _func.call(afArray0, afArray1).extract<af::array>();
+}
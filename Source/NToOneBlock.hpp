@@ -26,7 +26,8 @@ class NToOneBlock: public ArrayFireBlock
             const Pothos::DType& dtype,
             size_t numChannels,
             const DTypeSupport& supportedTypes,
-            bool shouldPostBuffer);
+            bool shouldPostBuffer,
+            bool isAssociative);
 
         static Pothos::Block* makeCallable(
             const std::string& device,
@@ -34,7 +35,8 @@ class NToOneBlock: public ArrayFireBlock
             const Pothos::DType& dtype,
             size_t numChannels,
             const DTypeSupport& supportedTypes,
-            bool shouldPostBuffer);
+            bool shouldPostBuffer,
+            bool isAssociative);
 
         //
         // Class implementation
@@ -45,24 +47,35 @@ class NToOneBlock: public ArrayFireBlock
             const NToOneFunc& func,
             const Pothos::DType& dtype,
             size_t numChannels,
-            bool shouldPostBuffer);
+            bool shouldPostBuffer,
+            bool isAssociative);
 
         NToOneBlock(
             const std::string& device,
             const Pothos::Callable& func,
             const Pothos::DType& dtype,
             size_t numChannels,
-            bool shouldPostBuffer);
+            bool shouldPostBuffer,
+            bool isAssociative);
 
         virtual ~NToOneBlock();
 
         void work() override;
 
     private:
+        // Function pointers are called directly, avoiding the overhead of
+        // Pothos::Callable. Only one of these is set.
+        NToOneFunc _rawFunc;
         Pothos::Callable _func;
         size_t _nchans;
 
         bool _postBuffer;
+
+        // Associative operations are combined in a balanced tree, so
+        // independent pairs don't wait on each other.
+        bool _isAssociative;
+
+        af::array _combine(const af::array& afArray0, const af::array& afArray1) const;
 };
 
 #define AF_ARRAY_OP_N_TO_ONE_FUNC(op) \
@@ -1,4 +1,4 @@
-// Copyright (c) 2019-2020 Nicholas Corgan
+// Copyright (c) 2019-2020,2023 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include "BufferConversions.hpp"
@@ -14,10 +14,40 @@
 #include <Poco/Format.h>
 #include <Poco/NumberFormatter.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstring>
+#include <map>
+#include <mutex>
 #include <string>
 #include <typeinfo>
+#include <utility>
+#include <vector>
+
+// Used to pick a device for "Auto", since these are much more expensive per
+// element than other functions.
+static DeviceOpClass getOneToOneOpClass(const OneToOneFunc& func)
+{
+    static const std::vector<OneToOneFunc> TranscendentalFuncs =
+    {
+        &af::sin, &af::cos, &af::tan,
+        &af::asin, &af::acos, &af::atan,
+        &af::sinh, &af::cosh, &af::tanh,
+        &af::asinh, &af::acosh, &af::atanh,
+        &af::exp, &af::expm1,
+        &af::log, &af::log1p, &af::log10, &af::log2,
+        &af::erf, &af::erfc,
+        &af::tgamma, &af::lgamma
+    };
+
+    const bool isTranscendental = std::find(
+                                      TranscendentalFuncs.begin(),
+                                      TranscendentalFuncs.end(),
+                                      func) != TranscendentalFuncs.end();
+
+    return isTranscendental ? DeviceOpClass::Transcendental : DeviceOpClass::Elementwise;
+}
 
 //
 // Factories
@@ -98,44 +128,87 @@ OneToOneBlock::OneToOneBlock(
     const Pothos::DType& outputDType
 ): OneToOneBlock(
        device,
-       Pothos::Callable(func),
+       Pothos::Callable(),
        inputDType,
-       outputDType)
+       outputDType,
+       getOneToOneOpClass(func))
 {
+    _rawFunc = func;
+    _hostKernel = getOneToOneHostKernel(func, inputDType, outputDType);
+
+    // Without a host kernel, the threshold would be accepted and ignored.
+    if(_hostKernel)
+    {
+        this->registerCall(this, POTHOS_FCN_TUPLE(OneToOneBlock, hostFallbackThreshold));
+        this->registerCall(this, POTHOS_FCN_TUPLE(OneToOneBlock, setHostFallbackThreshold));
+    }
 }
 
 OneToOneBlock::OneToOneBlock(
     const std::string& device,
     const Pothos::Callable& func,
     const Pothos::DType& inputDType,
-    const Pothos::DType& outputDType
-): ArrayFireBlock(device),
+    const Pothos::DType& outputDType,
+    DeviceOpClass autoOpClass
+): ArrayFireBlock(device, autoOpClass),
    _func(func),
-   _afOutputDType(Pothos::Object(outputDType).convert<af::dtype>())
+   _afOutputDType(Pothos::Object(outputDType).convert<af::dtype>()),
+   _rawFunc(nullptr),
+   _hostKernel(nullptr),
+   _hostFallbackThreshold(0),
+   _calibrateHostFallback(true)
 {
     this->setupInput(0, inputDType, _domain);
     this->setupOutput(0, outputDType, _domain);
+
+    this->registerPipeliningCalls();
+    this->registerBatchingCalls();
 }
 
 OneToOneBlock::~OneToOneBlock() {}
 
+void OneToOneBlock::activate()
+{
+    ArrayFireBlock::activate();
+
+    if(_hostKernel && _calibrateHostFallback)
+    {
+        _hostFallbackThreshold = this->_getHostFallbackThreshold();
+    }
+}
+
 // Default behavior, can be overridden
 void OneToOneBlock::work()
 {
     // The thread may have changed since the block was created, so make sure
     // the backend and device still match.
-    af::setBackend(_afBackend);
-    af::setDevice(_afDevice);
+    this->configArrayFire();
 
-    const size_t elems = this->workInfo().minElements;
+    const size_t elems = this->getBatchElements(this->workInfo().minElements);
     if(0 == elems)
     {
+        this->flushPipelinedOutputs();
+        return;
+    }
+
+    if(_hostKernel && (elems <= _hostFallbackThreshold) && this->canProcessOnHost())
+    {
+        auto* inputPort = this->input(0);
+        auto* outputPort = this->output(0);
+
+        _hostKernel(
+            inputPort->buffer().as<const void*>(),
+            outputPort->buffer().as<void*>(),
+            elems);
+
+        inputPort->consume(elems);
+        outputPort->produce(elems);
         return;
     }
 
     auto afInput = this->getInputPortAsAfArray(0);
 
-    auto afOutput = _func.call(afInput).extract<af::array>();
+    auto afOutput = this->_apply(afInput);
     if(afOutput.type() != _afOutputDType)
     {
         afOutput = afOutput.as(_afOutputDType);
@@ -143,3 +216,101 @@ void OneToOneBlock::work()
 
     this->produceFromAfArray(0, afOutput);
 }
+
+af::array OneToOneBlock::_apply(const af::array& afInput) const
+{
+    if(_rawFunc) return _rawFunc(afInput);
+    else         return _func.call(afInput).extract<af::array>();
+}
+
+size_t OneToOneBlock::hostFallbackThreshold() const
+{
+    return _hostFallbackThreshold;
+}
+
+void OneToOneBlock::setHostFallbackThreshold(size_t hostFallbackThreshold)
+{
+    _hostFallbackThreshold = hostFallbackThreshold;
+    _calibrateHostFallback = false;
+}
+
+// Measuring takes a while, so only do it once per device and host kernel.
+// Each host kernel is specific to a function and type.
+size_t OneToOneBlock::_getHostFallbackThreshold()
+{
+    using DeviceKey = std::pair<af::Backend, int>;
+
+    static std::mutex thresholdsMutex;
+    static std::map<DeviceKey, std::map<OneToOneHostKernel, size_t>> thresholds;
+
+    const DeviceKey deviceKey(_afBackend, _afDevice);
+    {
+        std::lock_guard<std::mutex> lock(thresholdsMutex);
+
+        const auto& deviceThresholds = thresholds[deviceKey];
+        auto iter = deviceThresholds.find(_hostKernel);
+        if(deviceThresholds.end() != iter) return iter->second;
+    }
+
+    // Don't hold the lock while measuring. If another block measures the
+    // same thing at once, either result is fine.
+    const size_t threshold = this->_measureHostFallbackThreshold();
+
+    std::lock_guard<std::mutex> lock(thresholdsMutex);
+    thresholds[deviceKey][_hostKernel] = threshold;
+
+    return threshold;
+}
+
+// Returns the largest power-of-two chunk size the host kernel is faster for,
+// including everything work() would do to run the chunk through ArrayFire.
+size_t OneToOneBlock::_measureHostFallbackThreshold()
+{
+    static constexpr size_t MinElements = 16;
+    static constexpr size_t MaxElements = 1 << 16;
+    static constexpr size_t NumIterations = 20;
+
+    const auto afInputDType = Pothos::Object(this->input(0)->dtype()).convert<af::dtype>();
+
+    std::vector<unsigned char> input(MaxElements * this->input(0)->dtype().size());
+    std::vector<unsigned char> output(MaxElements * this->output(0)->dtype().size());
+    // Stay in the function's domain, since NaNs can take a different path
+    // through either implementation. Only these functions need |x| < 1.
+    static const std::vector<OneToOneFunc> UnitDomainFuncs = {&af::asin, &af::acos, &af::atanh};
+    const bool isUnitDomainFunc = (UnitDomainFuncs.end() != std::find(UnitDomainFuncs.begin(), UnitDomainFuncs.end(), _rawFunc));
+    const double calibrationValue = isUnitDomainFunc ? 0.5 : 1.5;
+
+    af::constant(calibrationValue, static_cast<dim_t>(MaxElements), afInputDType).host(input.data());
+
+    auto runAfIteration = [&](size_t elems)
+    {
+        af::array afInput(static_cast<dim_t>(elems), afInputDType);
+        afInput.write(input.data(), afInput.bytes());
+
+        auto afOutput = this->_apply(afInput);
+        afOutput.host(output.data());
+    };
+
+    // Don't count JIT compilation.
+    runAfIteration(MinElements);
+
+    size_t threshold = 0;
+    for(size_t elems = MinElements; elems <= MaxElements; elems *= 2)
+    {
+        const auto hostStartTime = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < NumIterations; ++i)
+        {
+            _hostKernel(input.data(), output.data(), elems);
+        }
+        const auto hostTime = std::chrono::steady_clock::now() - hostStartTime;
+
+        const auto afStartTime = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < NumIterations; ++i) runAfIteration(elems);
+        const auto afTime = std::chrono::steady_clock::now() - afStartTime;
+
+        if(hostTime >= afTime) break;
+        threshold = elems;
+    }
+
+    return threshold;
+}
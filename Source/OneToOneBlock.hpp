@@ -1,9 +1,10 @@
-// Copyright (c) 2019-2020 Nicholas Corgan
+// Copyright (c) 2019-2020,2023 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
 #pragma once
 
 #include "ArrayFireBlock.hpp"
+#include "HostKernels.hpp"
 #include "Utility.hpp"
 
 #include <Pothos/Callable.hpp>
@@ -58,16 +59,42 @@ class OneToOneBlock: public ArrayFireBlock
             const std::string& device,
             const Pothos::Callable& func,
             const Pothos::DType& inputDType,
-            const Pothos::DType& outputDType);
+            const Pothos::DType& outputDType,
+            DeviceOpClass autoOpClass = DeviceOpClass::Elementwise);
 
         virtual ~OneToOneBlock();
 
+        void activate() override;
+
         void work() override;
 
+        size_t hostFallbackThreshold() const;
+
+        void setHostFallbackThreshold(size_t hostFallbackThreshold);
+
     protected:
 
         Pothos::Callable _func;
 
         // We need to store this since ArrayFire may change the output type.
         af::dtype _afOutputDType;
+
+    private:
+        // Function pointers are called directly, avoiding the overhead of
+        // Pothos::Callable. Only one of these is set.
+        OneToOneFunc _rawFunc;
+
+        af::array _apply(const af::array& afInput) const;
+
+        // Only set for functions with a host equivalent. Chunks up to the
+        // threshold are processed on the host, and unless the threshold is
+        // set explicitly, it's measured the first time a block with the same
+        // function, type, and device is activated.
+        OneToOneHostKernel _hostKernel;
+        size_t _hostFallbackThreshold;
+        bool _calibrateHostFallback;
+
+        size_t _getHostFallbackThreshold();
+
+        size_t _measureHostFallbackThreshold();
 };
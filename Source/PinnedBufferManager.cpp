@@ -2,6 +2,7 @@
 //                    2020 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include "ArrayFireContext.hpp"
 #include "BufferConversions.hpp"
 #include "DeviceCache.hpp"
 #include "SharedBufferAllocator.hpp"
@@ -36,8 +37,7 @@ public:
 
     void init(const Pothos::BufferManagerArgs &args)
     {
-        af::setBackend(_backend);
-        af::setDevice(0);
+        setThreadArrayFireContext(_backend, 0);
 
         Pothos::BufferManager::init(args);
         _bufferSize = args.bufferSize;
@@ -130,6 +130,8 @@ class RandomBlock: public ArrayFireBlock
                 return;
             }
 
+            this->configArrayFire();
+
             const af::dim4 dims(static_cast<dim_t>(elems));
 
             auto afOutput = _afRandomFunc(dims, _afDType, _afRandomEngine);
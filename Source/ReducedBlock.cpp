@@ -1,7 +1,9 @@
-// Copyright (c) 2019-2020 Nicholas Corgan
+// Copyright (c) 2019-2020,2023 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include "DeviceBuffer.hpp"
 #include "ReducedBlock.hpp"
+#include "SharedBufferAllocator.hpp"
 #include "Utility.hpp"
 
 #include <Pothos/Exception.hpp>
@@ -14,8 +16,10 @@
 #include <arrayfire.h>
 
 #include <cassert>
+#include <cstring>
 #include <string>
 #include <typeinfo>
+#include <vector>
 
 ReducedBlock::ReducedBlock(
     const std::string& device,
@@ -41,6 +45,10 @@ ReducedBlock::ReducedBlock(
         this->setupInput(chan, inputDType, _domain);
     }
     this->setupOutput(0, outputDType, _domain);
+
+    this->registerPipeliningCalls();
+
+    this->registerBatchingCalls();
 }
 
 ReducedBlock::~ReducedBlock() {}
@@ -51,43 +59,88 @@ af::array ReducedBlock::getNumberedInputPortsAs2DAfArray()
     //  * We've already checked that all buffers are non-empty.
     //  * We only have numbered ports.
     //  * All DTypes are the same.
+    //
+    // Each channel is a column, so each channel's input is contiguous and
+    // the reduction is over dim 1.
     const auto& inputs = this->inputs();
 
-    const auto dim0 = static_cast<dim_t>(inputs.size());
-    const auto dim1 = static_cast<dim_t>(this->workInfo().minElements);
-    const auto afDType = Pothos::Object(inputs[0]->dtype()).convert<af::dtype>();
+    // If batching, the inputs have already been consumed onto the device.
+    // On the CPU backend, host inputs are wrapped in place, so staging them
+    // would only add a copy.
+    bool shouldStageInputs = (0 == this->minBatchElements()) && (::AF_BACKEND_CPU != _afBackend);
+    for(const auto* inputPort: inputs)
+    {
+        shouldStageInputs &= !isDeviceBufferChunk(inputPort->buffer());
+    }
+
+    if(shouldStageInputs) return this->_stageHostInputs();
 
-    af::array ret(dim0, dim1, afDType);
-    for(dim_t row = 0; row < dim0; ++row)
+    std::vector<af::array> afArrays;
+    for(size_t chan = 0; chan < inputs.size(); ++chan)
     {
-        auto afArray = this->getInputPortAsAfArray(row);
-        if(afArray.elements() != dim1)
+        afArrays.emplace_back(this->getInputPortAsAfArray(chan));
+        if(afArrays.back().elements() != afArrays[0].elements())
         {
             throw Pothos::AssertionViolationException(
                       "getInputPortAsAfArray() returned an af::array of invalid size",
                       Poco::format(
                           "Expected %s, got %s",
-                          Poco::NumberFormatter::format(dim1),
-                          Poco::NumberFormatter::format(afArray.elements())));
+                          Poco::NumberFormatter::format(afArrays[0].elements()),
+                          Poco::NumberFormatter::format(afArrays.back().elements())));
         }
+    }
+
+    return joinAfArrays(1, afArrays);
+}
+
+af::array ReducedBlock::_stageHostInputs()
+{
+    // Gather all inputs into one pinned buffer so they can be uploaded in a
+    // single transfer.
+    const auto& inputs = this->inputs();
+    const size_t elems = this->workInfo().minAllElements;
+    const auto& dtype = inputs[0]->dtype();
+    const size_t channelBytes = elems * dtype.size();
+    const size_t totalBytes = channelBytes * inputs.size();
+
+    if(_stagingBuffer.getLength() < totalBytes)
+    {
+        _stagingBuffer = allocateSharedBuffer(_afBackend, totalBytes);
+    }
 
-        ret.row(row) = afArray;
+    auto* stagingBuffer = reinterpret_cast<unsigned char*>(_stagingBuffer.getAddress());
+    for(auto* inputPort: inputs)
+    {
+        std::memcpy(stagingBuffer, inputPort->buffer().as<const void*>(), channelBytes);
+        inputPort->consume(elems);
+
+        stagingBuffer += channelBytes;
     }
 
-    return ret;
+    Pothos::BufferChunk stagedChunk(_stagingBuffer);
+    stagedChunk.dtype = dtype;
+    stagedChunk.length = totalBytes;
+
+    return af::moddims(
+               this->uploadBufferChunk(stagedChunk),
+               static_cast<dim_t>(elems),
+               static_cast<dim_t>(inputs.size()));
 }
 
 void ReducedBlock::work()
 {
-    const size_t elems = this->workInfo().minAllElements;
+    this->configArrayFire();
+
+    const size_t elems = this->getBatchElements(this->workInfo().minAllElements);
 
     if(0 == elems)
     {
+        this->flushPipelinedOutputs();
         return;
     }
 
     auto afArray = this->getNumberedInputPortsAs2DAfArray();
-    auto afOutput = _func(afArray, -1).as(_afOutputDType);
+    auto afOutput = _func(afArray, 1).as(_afOutputDType);
 
     if(elems != static_cast<size_t>(afOutput.elements()))
     {
@@ -34,4 +34,9 @@ class ReducedBlock: public ArrayFireBlock
         ReducedFunc _func;
         af::dtype _afOutputDType;
         size_t _nchans;
+
+        // Reused across calls, since pinned memory is expensive to allocate.
+        Pothos::SharedBuffer _stagingBuffer;
+
+        af::array _stageHostInputs();
 };
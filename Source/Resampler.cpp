@@ -0,0 +1,303 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "ArrayFireBlock.hpp"
+#include "Utility.hpp"
+
+#include <Pothos/Exception.hpp>
+#include <Pothos/Framework.hpp>
+#include <Pothos/Object.hpp>
+
+#include <arrayfire.h>
+
+#include <algorithm>
+#include <complex>
+#include <string>
+#include <vector>
+
+//
+// Conceptually, the input is upsampled by inserting (interpolation-1) zeros
+// after each sample, filtered, and every decimation'th sample is kept. Only
+// the kept outputs are computed, and the zeros are skipped by splitting the
+// taps into (interpolation) phases, each of which only sees real samples.
+//
+
+template <typename T>
+class ResamplerBlock: public ArrayFireBlock
+{
+    public:
+        using Type = T;
+        using Class = ResamplerBlock<T>;
+        using TapType = typename Tap<T>::Type;
+
+        static const Pothos::DType dtype;
+
+        ResamplerBlock(
+            const std::string& device,
+            size_t dtypeDims,
+            size_t interpolation,
+            size_t decimation
+        ):
+            ArrayFireBlock(device),
+            _interpolation(interpolation),
+            _decimation(decimation),
+            _numPhaseTaps(0),
+            _nextOutputPosition(0)
+        {
+            if(0 == _interpolation)
+            {
+                throw Pothos::InvalidArgumentException("Interpolation must be > 0.");
+            }
+            if(0 == _decimation)
+            {
+                throw Pothos::InvalidArgumentException("Decimation must be > 0.");
+            }
+
+            this->setupInput(0, Pothos::DType::fromDType(Class::dtype, dtypeDims), _domain);
+            this->setupOutput(0, Pothos::DType::fromDType(Class::dtype, dtypeDims), _domain);
+
+            this->setTaps({TapType(1.0)});
+
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, interpolation));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, decimation));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, taps));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, setTaps));
+            this->registerPipeliningCalls();
+            this->registerBatchingCalls();
+        }
+
+        virtual ~ResamplerBlock() = default;
+
+        void activate() override
+        {
+            ArrayFireBlock::activate();
+
+            this->_resetState();
+        }
+
+        size_t interpolation() const
+        {
+            return _interpolation;
+        }
+
+        size_t decimation() const
+        {
+            return _decimation;
+        }
+
+        std::vector<TapType> taps() const
+        {
+            return _taps;
+        }
+
+        void setTaps(const std::vector<TapType>& taps)
+        {
+            if(taps.empty())
+            {
+                throw Pothos::InvalidArgumentException("Taps cannot be empty.");
+            }
+
+            this->configArrayFire();
+
+            // Column p holds the taps for phase p: h[p], h[p+L], h[p+2L]...
+            const size_t numPhaseTaps = (taps.size() + _interpolation - 1) / _interpolation;
+            std::vector<TapType> polyphaseTaps(numPhaseTaps * _interpolation, TapType(0));
+            for(size_t tap = 0; tap < taps.size(); ++tap)
+            {
+                const size_t phase = tap % _interpolation;
+                const size_t phaseTap = tap / _interpolation;
+
+                // Column-major, to match ArrayFire
+                polyphaseTaps[phaseTap + (phase * numPhaseTaps)] = taps[tap];
+            }
+
+            _taps = taps;
+            _afPolyphaseTaps = af::moddims(
+                                   Pothos::Object(polyphaseTaps).convert<af::array>(),
+                                   static_cast<dim_t>(numPhaseTaps),
+                                   static_cast<dim_t>(_interpolation));
+
+            if(numPhaseTaps != _numPhaseTaps)
+            {
+                _numPhaseTaps = numPhaseTaps;
+                this->_resetHistory();
+            }
+        }
+
+        void work() override
+        {
+            // The thread may have changed since the block was created, so make sure
+            // the backend and device still match.
+            this->configArrayFire();
+
+            // Only take as much input as there's room to output.
+            const size_t maxInputs = ((this->output(0)->elements() * _decimation) + _nextOutputPosition) / _interpolation;
+            const size_t elems = this->getBatchElements(std::min(this->input(0)->elements(), maxInputs));
+            if(0 == elems)
+            {
+                this->flushPipelinedOutputs();
+                return;
+            }
+
+            auto afOutput = this->_resample(this->consumeInputPortAsAfArray(0, elems));
+            if(afOutput.elements() > 0) this->produceFromAfArray(0, afOutput);
+        }
+
+    private:
+        size_t _interpolation;
+        size_t _decimation;
+
+        std::vector<TapType> _taps;
+        size_t _numPhaseTaps;
+        af::array _afPolyphaseTaps;
+
+        // The last (numPhaseTaps-1) input samples, kept on the device.
+        af::array _afHistory;
+
+        // Where the next output falls in the upsampled stream, relative to
+        // the first sample of the next input chunk.
+        size_t _nextOutputPosition;
+
+        void _resetHistory()
+        {
+            if(_numPhaseTaps > 1)
+            {
+                _afHistory = af::constant(
+                                 0,
+                                 static_cast<dim_t>(_numPhaseTaps-1),
+                                 Pothos::Object(Class::dtype).convert<af::dtype>());
+            }
+            else _afHistory = af::array();
+        }
+
+        void _resetState()
+        {
+            this->_resetHistory();
+            _nextOutputPosition = 0;
+        }
+
+        af::array _resample(const af::array& afInput)
+        {
+            const size_t numInputs = afInput.elements();
+            const size_t numUpsampled = numInputs * _interpolation;
+
+            auto afSignal = _afHistory.isempty() ? afInput : af::join(0, _afHistory, afInput);
+
+            af::array afOutput;
+            if(_nextOutputPosition < numUpsampled)
+            {
+                const size_t numOutputs = (numUpsampled - _nextOutputPosition + _decimation - 1) / _decimation;
+                const auto numOutputsDim = static_cast<dim_t>(numOutputs);
+                const auto numPhaseTapsDim = static_cast<dim_t>(_numPhaseTaps);
+
+                // For each output, the newest input sample it sees and which
+                // phase of the taps applies.
+                auto afPositions = (af::range(af::dim4(numOutputsDim), 0, ::u32) * static_cast<unsigned>(_decimation))
+                                 + static_cast<unsigned>(_nextOutputPosition);
+                auto afNewestInputs = afPositions / static_cast<unsigned>(_interpolation);
+                auto afPhases = afPositions - (afNewestInputs * static_cast<unsigned>(_interpolation));
+
+                // Gather each output's samples as a column, newest first,
+                // offset by the history prepended to the input.
+                auto afIndices = af::tile(af::moddims(afNewestInputs, 1, numOutputsDim), static_cast<unsigned>(_numPhaseTaps), 1)
+                               + (static_cast<unsigned>(_numPhaseTaps-1) - af::range(af::dim4(numPhaseTapsDim, numOutputsDim), 0, ::u32));
+                auto afSamples = af::moddims(afSignal(af::flat(afIndices)), numPhaseTapsDim, numOutputsDim);
+
+                auto afCoeffs = _afPolyphaseTaps(af::span, afPhases);
+                afOutput = af::flat(af::sum(afSamples * afCoeffs, 0));
+
+                _nextOutputPosition += (numOutputs * _decimation);
+            }
+            _nextOutputPosition -= numUpsampled;
+
+            if(!_afHistory.isempty())
+            {
+                const size_t signalLength = afSignal.elements();
+                _afHistory = afSignal(af::seq(
+                                 static_cast<double>(signalLength - _afHistory.elements()),
+                                 static_cast<double>(signalLength - 1)));
+                _afHistory.eval();
+            }
+
+            return afOutput;
+        }
+};
+
+template <typename T>
+const Pothos::DType ResamplerBlock<T>::dtype(typeid(T));
+
+//
+// Factory
+//
+
+static Pothos::Block* makeResampler(
+    const std::string& device,
+    const Pothos::DType& dtype,
+    size_t interpolation,
+    size_t decimation)
+{
+    #define ifTypeDeclareFactory(T) \
+        if(Pothos::DType::fromDType(dtype, 1) == Pothos::DType(typeid(T))) \
+            return new ResamplerBlock<T>(device, dtype.dimension(), interpolation, decimation);
+
+    ifTypeDeclareFactory(float)
+    ifTypeDeclareFactory(double)
+    ifTypeDeclareFactory(std::complex<float>)
+    ifTypeDeclareFactory(std::complex<double>)
+    #undef ifTypeDeclareFactory
+
+    throw Pothos::InvalidArgumentException(
+              "Unsupported type.",
+              dtype.name());
+}
+
+//
+// Block registries
+//
+
+/*
+ * |PothosDoc Rational Resampler (GPU)
+ *
+ * Changes the input's sample rate by a factor of <b>interpolation/decimation</b>
+ * with a polyphase filter. This is equivalent to inserting (interpolation-1)
+ * zeros after each input sample, filtering with the given taps, and keeping
+ * every decimation'th output, but only the kept outputs are computed.
+ *
+ * The taps should be a low-pass filter designed for the upsampled rate, with
+ * a cutoff at the lower of the input and output Nyquist frequencies. They can
+ * be set at runtime by connecting the output of a FIR Designer block to
+ * <b>"setTaps"</b>. The filter's history and phase are kept between calls,
+ * so the output doesn't depend on how the input stream is split up.
+ *
+ * |category /GPU/Signal
+ * |category /Filter/GPU
+ * |keywords array tap taps fir resample interpolate decimate polyphase rate
+ * |factory /gpu/signal/resampler(device,dtype,interpolation,decimation)
+ * |setter setTaps(taps)
+ *
+ * |param device[Device] Device to use for processing.
+ * |default "Auto"
+ *
+ * |param dtype[Data Type] The output's data type.
+ * |widget DTypeChooser(float=1,cfloat=1,dim=1)
+ * |default "complex_float64"
+ * |preview disable
+ *
+ * |param interpolation[Interpolation] The upsampling factor.
+ * |widget SpinBox(minimum=1)
+ * |default 1
+ * |preview enable
+ *
+ * |param decimation[Decimation] The downsampling factor.
+ * |widget SpinBox(minimum=1)
+ * |default 1
+ * |preview enable
+ *
+ * |param taps[Taps] The low-pass filter taps, at the upsampled rate.
+ * |widget LineEdit()
+ * |default [1.0]
+ * |preview enable
+ */
+static Pothos::BlockRegistry registerResampler(
+    "/gpu/signal/resampler",
+    Pothos::Callable(&makeResampler));
@@ -0,0 +1,378 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "ArrayFireBlock.hpp"
+#include "FFTPlanCache.hpp"
+#include "SignalUtility.hpp"
+#include "Utility.hpp"
+
+#include <Pothos/Exception.hpp>
+#include <Pothos/Framework.hpp>
+#include <Pothos/Object.hpp>
+
+#include <arrayfire.h>
+
+#include <algorithm>
+#include <complex>
+#include <string>
+#include <typeinfo>
+
+static constexpr size_t DefaultMaxFramesPerCall = 64;
+static constexpr double DefaultKaiserBeta = 8.6;
+
+static const std::string DefaultWindow = "Hann";
+
+//
+// Block class
+//
+
+template <typename In, typename Out>
+class STFTBlock: public ArrayFireBlock
+{
+    public:
+        using InType = In;
+        using OutType = Out;
+        using Class = STFTBlock<In, Out>;
+
+        STFTBlock(
+            const std::string& device,
+            size_t dtypeDims,
+            size_t numBins,
+            size_t hopSize,
+            const std::string& outputMode
+        ):
+            ArrayFireBlock(device, DeviceOpClass::FFT),
+            _numBins(numBins),
+            _hopSize(hopSize),
+            _outputMode(outputMode),
+            _window(DefaultWindow),
+            _kaiserBeta(DefaultKaiserBeta),
+            _maxFramesPerCall(DefaultMaxFramesPerCall)
+        {
+            if(0 == _numBins)
+            {
+                throw Pothos::InvalidArgumentException("numBins must be > 0.");
+            }
+            if((0 == _hopSize) || (_hopSize > _numBins))
+            {
+                throw Pothos::InvalidArgumentException("hopSize must be in the range [1, numBins].");
+            }
+
+            static const Pothos::DType inDType(typeid(InType));
+            static const Pothos::DType outDType(typeid(OutType));
+
+            this->setupInput(0, Pothos::DType::fromDType(inDType, dtypeDims), _domain);
+            this->setupOutput(0, Pothos::DType::fromDType(outDType, dtypeDims), _domain);
+
+            this->_updateWindow();
+
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, numBins));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, hopSize));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, outputMode));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, window));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, setWindow));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, kaiserBeta));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, setKaiserBeta));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, maxFramesPerCall));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, setMaxFramesPerCall));
+            this->registerPipeliningCalls();
+            this->registerBatchingCalls();
+        }
+
+        virtual ~STFTBlock() = default;
+
+        void activate() override
+        {
+            ArrayFireBlock::activate();
+
+            _afPending = af::array();
+            this->_reservePlans();
+        }
+
+        void deactivate() override
+        {
+            ArrayFireBlock::deactivate();
+
+            _planReservation.release();
+        }
+
+        size_t numBins() const
+        {
+            return _numBins;
+        }
+
+        size_t hopSize() const
+        {
+            return _hopSize;
+        }
+
+        std::string outputMode() const
+        {
+            return _outputMode;
+        }
+
+        std::string window() const
+        {
+            return _window;
+        }
+
+        void setWindow(const std::string& window)
+        {
+            const auto oldWindow = _window;
+            _window = window;
+
+            try
+            {
+                this->_updateWindow();
+            }
+            catch(...)
+            {
+                _window = oldWindow;
+                throw;
+            }
+        }
+
+        double kaiserBeta() const
+        {
+            return _kaiserBeta;
+        }
+
+        void setKaiserBeta(double kaiserBeta)
+        {
+            if(kaiserBeta < 0.0)
+            {
+                throw Pothos::InvalidArgumentException("kaiserBeta must be >= 0.");
+            }
+
+            _kaiserBeta = kaiserBeta;
+            this->_updateWindow();
+        }
+
+        size_t maxFramesPerCall() const
+        {
+            return _maxFramesPerCall;
+        }
+
+        void setMaxFramesPerCall(size_t maxFramesPerCall)
+        {
+            if(0 == maxFramesPerCall)
+            {
+                throw Pothos::InvalidArgumentException("maxFramesPerCall must be > 0.");
+            }
+
+            _maxFramesPerCall = maxFramesPerCall;
+            if(this->isActive()) this->_reservePlans();
+        }
+
+        void work() override
+        {
+            // The thread may have changed since the block was created, so make sure
+            // the backend and device still match.
+            this->configArrayFire();
+
+            // Only take as much input as the frames that fit in the output need.
+            // Pending samples are always fewer than numBins.
+            const size_t maxFrames = std::min(this->output(0)->elements() / _numBins, _maxFramesPerCall);
+            const size_t maxInputs = (maxFrames > 0) ? (((maxFrames-1) * _hopSize) + _numBins - static_cast<size_t>(_afPending.elements())) : 0;
+
+            const size_t elems = this->getBatchElements(std::min(this->input(0)->elements(), maxInputs));
+            if(0 == elems)
+            {
+                this->flushPipelinedOutputs();
+                return;
+            }
+
+            auto afInput = this->consumeInputPortAsAfArray(0, elems);
+            auto afSignal = _afPending.isempty() ? afInput : af::join(0, _afPending, afInput);
+
+            const size_t signalLength = afSignal.elements();
+            const size_t numFrames = (signalLength >= _numBins) ? (((signalLength - _numBins) / _hopSize) + 1) : 0;
+            if(numFrames > 0)
+            {
+                auto afOutput = this->_transform(getOverlappedFrames(afSignal, _numBins, _hopSize, numFrames), numFrames);
+                this->produceFromAfArray(0, af::flat(afOutput));
+            }
+
+            // Keep everything from the start of the next frame.
+            const size_t nextFrameStart = numFrames * _hopSize;
+            if(nextFrameStart < signalLength)
+            {
+                _afPending = afSignal(af::seq(
+                                 static_cast<double>(nextFrameStart),
+                                 static_cast<double>(signalLength - 1)));
+                _afPending.eval();
+            }
+            else _afPending = af::array();
+        }
+
+    private:
+        size_t _numBins;
+        size_t _hopSize;
+        std::string _outputMode;
+
+        std::string _window;
+        double _kaiserBeta;
+        af::array _afWindow;
+
+        size_t _maxFramesPerCall;
+
+        // Input samples from the start of the next frame, kept on the device.
+        af::array _afPending;
+
+        FFTPlanReservation _planReservation;
+
+        void _reservePlans()
+        {
+            static const Pothos::DType inDType(typeid(InType));
+
+            _planReservation.reserve(
+                _afBackend,
+                _afDevice,
+                {getC2CFFTPlanKey(Pothos::Object(inDType).convert<af::dtype>(), _numBins, _maxFramesPerCall)});
+        }
+
+        void _updateWindow()
+        {
+            static const Pothos::DType inDType(typeid(InType));
+
+            this->configArrayFire();
+
+            _afWindow = getWindow(
+                            _window,
+                            _numBins,
+                            _kaiserBeta,
+                            Pothos::Object(inDType).convert<af::dtype>());
+        }
+
+        // The window multiply and power conversion are element-wise, so
+        // ArrayFire's JIT fuses each into a single kernel around the FFT.
+        af::array _transform(const af::array& afFrames, size_t numFrames)
+        {
+            auto afWindowed = afFrames * af::tile(_afWindow, 1, static_cast<unsigned>(numFrames));
+            auto afSpectrum = af::fft(IsComplex<InType>::value ? afWindowed : af::complex(afWindowed));
+
+            if("Complex" == _outputMode) return afSpectrum;
+
+            auto afPower = (af::real(afSpectrum) * af::real(afSpectrum)) + (af::imag(afSpectrum) * af::imag(afSpectrum));
+            return ("dB" == _outputMode) ? (10.0 * af::log10(afPower)) : afPower;
+        }
+};
+
+//
+// Factory
+//
+
+static Pothos::Block* makeSTFT(
+    const std::string& device,
+    const Pothos::DType& dtype,
+    size_t numBins,
+    size_t hopSize,
+    const std::string& outputMode)
+{
+    const bool isComplexOutput = ("Complex" == outputMode);
+    if(!isComplexOutput && ("MagnitudeSquared" != outputMode) && ("dB" != outputMode))
+    {
+        throw Pothos::InvalidArgumentException("Invalid output mode", outputMode);
+    }
+
+    #define __ifTypeDeclareFactory(InType, FloatType) \
+        if(Pothos::DType::fromDType(dtype, 1) == Pothos::DType(typeid(InType))) \
+        { \
+            if(isComplexOutput) return new STFTBlock<InType, std::complex<FloatType>>(device, dtype.dimension(), numBins, hopSize, outputMode); \
+            else                return new STFTBlock<InType, FloatType>(device, dtype.dimension(), numBins, hopSize, outputMode); \
+        }
+    #define ifTypeDeclareFactory(FloatType) \
+        __ifTypeDeclareFactory(FloatType, FloatType) \
+        __ifTypeDeclareFactory(std::complex<FloatType>, FloatType)
+
+    ifTypeDeclareFactory(float)
+    ifTypeDeclareFactory(double)
+    #undef ifTypeDeclareFactory
+    #undef __ifTypeDeclareFactory
+
+    throw Pothos::InvalidArgumentException(
+              "Unsupported type.",
+              dtype.name());
+}
+
+//
+// Block registration
+//
+
+/*
+ * |PothosDoc Short-Time Fourier Transform (GPU)
+ *
+ * Windows overlapping frames of the input and takes the FFT of each. A new frame
+ * starts every <b>hopSize</b> samples, so a hop size of half or a quarter of
+ * <b>numBins</b> gives 50% or 75% overlap. The overlapping samples are kept on
+ * the device between calls, and all frames available are transformed in a
+ * single batched call, up to <b>maxFramesPerCall</b> frames.
+ *
+ * The window is computed once on the device whenever it changes. The output is
+ * <b>numBins</b> elements per frame, either the complex spectrum, its magnitude
+ * squared, or its magnitude squared in dB. Real inputs give the full spectrum.
+ *
+ * |category /GPU/Signal
+ * |category /FFT/GPU
+ * |keywords array signal fft stft fourier window spectrogram overlap hann hamming blackman kaiser
+ * |factory /gpu/signal/stft(device,dtype,numBins,hopSize,outputMode)
+ * |setter setWindow(window)
+ * |setter setKaiserBeta(kaiserBeta)
+ * |setter setMaxFramesPerCall(maxFramesPerCall)
+ *
+ * |param device[Device] Device to use for processing.
+ * |default "Auto"
+ *
+ * |param dtype[Data Type] The input's data type.
+ * |widget DTypeChooser(float=1,cfloat=1,dim=1)
+ * |default "complex_float64"
+ * |preview disable
+ *
+ * |param numBins[Num FFT Bins] The number of bins per FFT, which is also the window length.
+ * |default 1024
+ * |option 256
+ * |option 512
+ * |option 1024
+ * |option 2048
+ * |option 4096
+ * |option 8192
+ * |widget ComboBox(editable=true)
+ * |preview enable
+ *
+ * |param hopSize[Hop Size] The number of samples between the starts of consecutive frames.
+ * Must be no larger than <b>numBins</b>.
+ * |default 512
+ * |widget SpinBox(minimum=1)
+ * |preview enable
+ *
+ * |param outputMode[Output Mode] Whether to output the complex spectrum or its power.
+ * |widget ComboBox(editable=false)
+ * |option [Complex] "Complex"
+ * |option [Magnitude Squared] "MagnitudeSquared"
+ * |option [dB] "dB"
+ * |default "Complex"
+ * |preview enable
+ *
+ * |param window[Window] The window applied to each frame before the FFT.
+ * |widget ComboBox(editable=false)
+ * |option [Rectangular] "Rectangular"
+ * |option [Hann] "Hann"
+ * |option [Hamming] "Hamming"
+ * |option [Blackman-Harris] "BlackmanHarris"
+ * |option [Kaiser] "Kaiser"
+ * |default "Hann"
+ * |preview enable
+ *
+ * |param kaiserBeta[Kaiser Beta] The shape parameter for the Kaiser window.
+ * |widget DoubleSpinBox(minimum=0.0)
+ * |default 8.6
+ * |preview disable
+ *
+ * |param maxFramesPerCall[Max Frames Per Call] The most frames to transform at once.
+ * |widget SpinBox(minimum=1)
+ * |default 64
+ * |preview disable
+ */
+static Pothos::BlockRegistry registerSTFT(
+    "/gpu/signal/stft",
+    Pothos::Callable(&makeSTFT));
@@ -0,0 +1,317 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <Pothos/Exception.hpp>
+#include <Pothos/Framework.hpp>
+#include <Pothos/Object.hpp>
+#include <Pothos/Proxy.hpp>
+
+#include <Poco/Format.h>
+#include <Poco/NumberFormatter.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+//
+// The splitter and combiner step through the same schedule, so each chunk
+// comes back out of the shard it was sent to in the order it went in. This
+// only holds for blocks that output one element per input element.
+//
+
+class ShardSchedule
+{
+    public:
+        explicit ShardSchedule(const std::vector<size_t>& shardElems):
+            _shardElems(shardElems),
+            _shard(0),
+            _remaining(shardElems[0])
+        {}
+
+        inline size_t shard() const
+        {
+            return _shard;
+        }
+
+        inline size_t remaining() const
+        {
+            return _remaining;
+        }
+
+        void advance(size_t elems)
+        {
+            _remaining -= elems;
+            if(0 == _remaining)
+            {
+                _shard = (_shard + 1) % _shardElems.size();
+                _remaining = _shardElems[_shard];
+            }
+        }
+
+    private:
+        std::vector<size_t> _shardElems;
+        size_t _shard;
+        size_t _remaining;
+};
+
+// Posts slices of the input buffer to each shard without copying.
+class ShardSplitter: public Pothos::Block
+{
+    public:
+        ShardSplitter(
+            const Pothos::DType& dtype,
+            const std::vector<size_t>& shardElems
+        ):
+            Pothos::Block(),
+            _schedule(shardElems)
+        {
+            this->setupInput(0, dtype);
+            for(size_t shard = 0; shard < shardElems.size(); ++shard)
+            {
+                this->setupOutput(shard, dtype);
+            }
+        }
+
+        void work() override
+        {
+            auto* inputPort = this->input(0);
+            const size_t elemSize = inputPort->dtype().size();
+
+            size_t elemsLeft = inputPort->elements();
+            size_t elemsPosted = 0;
+            while(elemsLeft > 0)
+            {
+                const size_t elems = std::min(elemsLeft, _schedule.remaining());
+
+                auto bufferChunk = inputPort->buffer();
+                bufferChunk.address += (elemsPosted * elemSize);
+                bufferChunk.length = elems * elemSize;
+                this->output(_schedule.shard())->postBuffer(std::move(bufferChunk));
+
+                _schedule.advance(elems);
+                elemsPosted += elems;
+                elemsLeft -= elems;
+            }
+
+            inputPort->consume(elemsPosted);
+        }
+
+    private:
+        ShardSchedule _schedule;
+};
+
+// Forwards each shard's outputs in the order the splitter sent them.
+class ShardCombiner: public Pothos::Block
+{
+    public:
+        ShardCombiner(
+            const Pothos::DType& dtype,
+            const std::vector<size_t>& shardElems
+        ):
+            Pothos::Block(),
+            _schedule(shardElems)
+        {
+            for(size_t shard = 0; shard < shardElems.size(); ++shard)
+            {
+                this->setupInput(shard, dtype);
+            }
+            this->setupOutput(0, dtype);
+        }
+
+        void work() override
+        {
+            auto* outputPort = this->output(0);
+            const size_t elemSize = outputPort->dtype().size();
+
+            while(true)
+            {
+                auto* inputPort = this->input(_schedule.shard());
+                const size_t elems = std::min(inputPort->elements(), _schedule.remaining());
+                if(0 == elems) return;
+
+                auto bufferChunk = inputPort->buffer();
+                bufferChunk.length = elems * elemSize;
+                outputPort->postBuffer(std::move(bufferChunk));
+                inputPort->consume(elems);
+
+                _schedule.advance(elems);
+            }
+        }
+
+    private:
+        ShardSchedule _schedule;
+};
+
+class Sharded: public Pothos::Topology
+{
+    public:
+        static Pothos::Topology* make(
+            const std::string& blockPath,
+            const std::vector<std::string>& devices,
+            const std::vector<double>& weights,
+            size_t chunkSize,
+            const std::vector<Pothos::Object>& blockArgs)
+        {
+            return new Sharded(blockPath, devices, weights, chunkSize, blockArgs);
+        }
+
+        Sharded(
+            const std::string& blockPath,
+            const std::vector<std::string>& devices,
+            const std::vector<double>& weights,
+            size_t chunkSize,
+            const std::vector<Pothos::Object>& blockArgs
+        ):
+            Pothos::Topology(),
+            _devices(devices),
+            _weights(weights)
+        {
+            if(_devices.empty())
+            {
+                throw Pothos::InvalidArgumentException("At least one device must be given.");
+            }
+            if(_weights.empty())
+            {
+                _weights.resize(_devices.size(), 1.0);
+            }
+            else if(_weights.size() != _devices.size())
+            {
+                throw Pothos::InvalidArgumentException(
+                          "There must be one weight per device.",
+                          Poco::format(
+                              "Devices: %s, weights: %s",
+                              Poco::NumberFormatter::format(_devices.size()),
+                              Poco::NumberFormatter::format(_weights.size())));
+            }
+            if(0 == chunkSize)
+            {
+                throw Pothos::InvalidArgumentException("chunkSize must be > 0.");
+            }
+
+            std::vector<size_t> shardElems;
+            for(double weight: _weights)
+            {
+                if(weight <= 0.0)
+                {
+                    throw Pothos::RangeException("Weights must be positive.");
+                }
+
+                shardElems.emplace_back(std::max<size_t>(1, std::lround(chunkSize * weight)));
+            }
+
+            // Instantiate the block on each device through the registry, with
+            // the device inserted as the first factory parameter.
+            auto env = Pothos::ProxyEnvironment::make("managed");
+            auto registry = env->findProxy("Pothos/BlockRegistry");
+            for(const auto& device: _devices)
+            {
+                std::vector<Pothos::Proxy> factoryArgs;
+                factoryArgs.emplace_back(env->makeProxy(device));
+                for(const auto& blockArg: blockArgs)
+                {
+                    factoryArgs.emplace_back(env->convertObjectToProxy(blockArg));
+                }
+
+                _shards.emplace_back(registry.getHandle()->call(
+                                         blockPath,
+                                         factoryArgs.data(),
+                                         factoryArgs.size()));
+            }
+
+            const auto inputDType = _shards[0].call("input", 0).call<Pothos::DType>("dtype");
+            const auto outputDType = _shards[0].call("output", 0).call<Pothos::DType>("dtype");
+
+            _splitter.reset(new ShardSplitter(inputDType, shardElems));
+            _combiner.reset(new ShardCombiner(outputDType, shardElems));
+
+            this->connect(this, 0, _splitter, 0);
+            for(size_t shard = 0; shard < _shards.size(); ++shard)
+            {
+                this->connect(_splitter, shard, _shards[shard], 0);
+                this->connect(_shards[shard], 0, _combiner, shard);
+            }
+            this->connect(_combiner, 0, this, 0);
+
+            this->registerCall(this, POTHOS_FCN_TUPLE(Sharded, devices));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Sharded, weights));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Sharded, shard));
+        }
+
+        virtual ~Sharded() = default;
+
+        std::vector<std::string> devices() const
+        {
+            return _devices;
+        }
+
+        std::vector<double> weights() const
+        {
+            return _weights;
+        }
+
+        Pothos::Proxy shard(size_t index) const
+        {
+            if(index >= _shards.size())
+            {
+                throw Pothos::RangeException(
+                          "Invalid shard index",
+                          Poco::NumberFormatter::format(index));
+            }
+
+            return _shards[index];
+        }
+
+    private:
+        std::vector<std::string> _devices;
+        std::vector<double> _weights;
+
+        std::shared_ptr<Pothos::Block> _splitter;
+        std::shared_ptr<Pothos::Block> _combiner;
+        std::vector<Pothos::Proxy> _shards;
+};
+
+/*
+ * |PothosDoc Sharded (GPU)
+ *
+ * Runs a GPU block on multiple devices at once. Input is split into chunks,
+ * which are sent to each device in turn, and the outputs are reassembled in
+ * order. A device with a higher weight is given proportionally larger chunks.
+ * The same device can be given more than once.
+ *
+ * Only blocks with a single input and output that output one element per
+ * input element are supported, such as <b>/gpu/arith/abs</b>. The block's
+ * factory parameters are given without the device, which is inserted for
+ * each shard.
+ *
+ * |category /GPU/Utility
+ * |keywords multiple device parallel split shard
+ * |factory /gpu/util/sharded(blockPath,devices,weights,chunkSize,blockArgs)
+ *
+ * |param blockPath[Block Path] The registry path of the block to shard.
+ * |widget StringEntry()
+ * |default "/gpu/arith/abs"
+ * |preview enable
+ *
+ * |param devices[Devices] The device to use for each shard.
+ * |default ["Auto", "Auto"]
+ * |preview enable
+ *
+ * |param weights[Weights] The relative amount of work for each device. If empty, all devices are given equal work.
+ * |default []
+ * |preview enable
+ *
+ * |param chunkSize[Chunk Size] The number of elements sent to a device with a weight of 1 in each round.
+ * |widget SpinBox(minimum=1)
+ * |default 4096
+ * |units elements
+ * |preview enable
+ *
+ * |param blockArgs[Block Arguments] The block's remaining factory parameters, after the device.
+ * |default ["float64"]
+ * |preview enable
+ */
+static Pothos::BlockRegistry registerSharded(
+    "/gpu/util/sharded",
+    Pothos::Callable(&Sharded::make));
@@ -1,17 +1,175 @@
-// Copyright (c) 2019-2020 Nicholas Corgan
+// Copyright (c) 2019-2020,2023 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include "ArrayFireContext.hpp"
 #include "SharedBufferAllocator.hpp"
 
 #include <Pothos/Framework.hpp>
+#include <Pothos/Plugin.hpp>
+
+#include <nlohmann/json.hpp>
 
 #include <arrayfire.h>
 
+#include <map>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+//
+// Page-locking memory is expensive, so instead of freeing pinned memory when
+// the last SharedBuffer reference drops, return it to a pool of power-of-two
+// size classes for each backend. Idle memory held by the pool is capped.
+//
+
+static constexpr size_t MinSizeClass = 4096;
+static constexpr size_t DefaultPoolCapacity = 256 * 1024 * 1024;
+
+static size_t getSizeClass(size_t size)
+{
+    size_t sizeClass = MinSizeClass;
+    while(sizeClass < size) sizeClass <<= 1;
+
+    return sizeClass;
+}
+
+class PinnedMemoryPool
+{
+    public:
+        using SPtr = std::shared_ptr<PinnedMemoryPool>;
+
+        PinnedMemoryPool():
+            _capacity(DefaultPoolCapacity),
+            _cachedBytes(0),
+            _hits(0),
+            _misses(0)
+        {}
+
+        virtual ~PinnedMemoryPool()
+        {
+            this->clear();
+        }
+
+        void* allocate(af::Backend backend, size_t sizeClass)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+
+                auto& freeList = _freeLists[PoolKey(backend, sizeClass)];
+                if(!freeList.empty())
+                {
+                    void* pinnedMem = freeList.back();
+                    freeList.pop_back();
+                    _cachedBytes -= sizeClass;
+                    ++_hits;
+
+                    return pinnedMem;
+                }
+
+                ++_misses;
+            }
+
+            setThreadArrayFireBackend(backend);
+            return af::pinned(sizeClass, ::u8);
+        }
+
+        void release(af::Backend backend, size_t sizeClass, void* pinnedMem)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+
+                if((_cachedBytes + sizeClass) <= _capacity)
+                {
+                    _freeLists[PoolKey(backend, sizeClass)].emplace_back(pinnedMem);
+                    _cachedBytes += sizeClass;
+
+                    return;
+                }
+            }
+
+            setThreadArrayFireBackend(backend);
+            af::freePinned(pinnedMem);
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            for(auto& freeListPair: _freeLists)
+            {
+                setThreadArrayFireBackend(freeListPair.first.first);
+                for(void* pinnedMem: freeListPair.second)
+                {
+                    try {af::freePinned(pinnedMem);}
+                    catch(...){}
+                }
+            }
+
+            _freeLists.clear();
+            _cachedBytes = 0;
+        }
+
+        size_t capacity() const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _capacity;
+        }
+
+        void setCapacity(size_t capacity)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _capacity = capacity;
+                if(_cachedBytes <= _capacity) return;
+            }
+
+            // Don't bother partially trimming, just start over.
+            this->clear();
+        }
+
+        std::string stats() const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            nlohmann::json topObj;
+            topObj["Capacity"] = _capacity;
+            topObj["Cached Bytes"] = _cachedBytes;
+            topObj["Hits"] = _hits;
+            topObj["Misses"] = _misses;
+
+            return topObj.dump();
+        }
+
+        void resetStats()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _hits = 0;
+            _misses = 0;
+        }
+
+    private:
+        using PoolKey = std::pair<af::Backend, size_t>;
+
+        mutable std::mutex _mutex;
+        std::map<PoolKey, std::vector<void*>> _freeLists;
+
+        size_t _capacity;
+        size_t _cachedBytes;
+        size_t _hits;
+        size_t _misses;
+};
+
+static PinnedMemoryPool::SPtr getPinnedMemoryPool()
+{
+    static PinnedMemoryPool::SPtr pool(new PinnedMemoryPool);
+    return pool;
+}
 
 //
 // Minimal wrapper class to ensure allocation and deallocation are done
-// with the same backend.
+// with the same backend. Holds a reference to the pool so it outlives any
+// buffers still in use at shutdown.
 //
 
 class AfPinnedMemRAII
@@ -20,19 +178,19 @@ class AfPinnedMemRAII
         using SPtr = std::shared_ptr<AfPinnedMemRAII>;
         
         AfPinnedMemRAII(af::Backend backend, size_t allocSize):
+            _pool(getPinnedMemoryPool()),
             _backend(backend),
+            _sizeClass(getSizeClass(allocSize)),
             _pinnedMem(nullptr)
         {
-            af::setBackend(_backend);
-            _pinnedMem = af::pinned(allocSize, ::u8);
+            _pinnedMem = _pool->allocate(_backend, _sizeClass);
         }
 
         virtual ~AfPinnedMemRAII()
         {
             try
             {
-                af::setBackend(_backend);
-                af::freePinned(_pinnedMem);
+                _pool->release(_backend, _sizeClass, _pinnedMem);
             }
             catch(...){}
         }
@@ -43,7 +201,9 @@ class AfPinnedMemRAII
         }
 
     private:
+        PinnedMemoryPool::SPtr _pool;
         af::Backend _backend;
+        size_t _sizeClass;
         void* _pinnedMem;
 };
 
@@ -72,3 +232,46 @@ BufferAllocateFcn getSharedBufferAllocator(af::Backend backend)
 
     return impl;
 }
+
+//
+// Pool configuration
+//
+
+static std::string pinnedMemoryPoolStats()
+{
+    return getPinnedMemoryPool()->stats();
+}
+
+static void resetPinnedMemoryPoolStats()
+{
+    getPinnedMemoryPool()->resetStats();
+}
+
+static size_t pinnedMemoryPoolCapacity()
+{
+    return getPinnedMemoryPool()->capacity();
+}
+
+static void setPinnedMemoryPoolCapacity(size_t capacity)
+{
+    getPinnedMemoryPool()->setCapacity(capacity);
+}
+
+static void clearPinnedMemoryPool()
+{
+    getPinnedMemoryPool()->clear();
+}
+
+pothos_static_block(registerPinnedMemoryPoolConfig)
+{
+    Pothos::PluginRegistry::addCall(
+        "/gpu/pinned_memory_pool/stats", &pinnedMemoryPoolStats);
+    Pothos::PluginRegistry::addCall(
+        "/gpu/pinned_memory_pool/reset_stats", &resetPinnedMemoryPoolStats);
+    Pothos::PluginRegistry::addCall(
+        "/gpu/pinned_memory_pool/capacity", &pinnedMemoryPoolCapacity);
+    Pothos::PluginRegistry::addCall(
+        "/gpu/pinned_memory_pool/set_capacity", &setPinnedMemoryPoolCapacity);
+    Pothos::PluginRegistry::addCall(
+        "/gpu/pinned_memory_pool/clear", &clearPinnedMemoryPool);
+}
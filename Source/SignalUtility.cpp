@@ -0,0 +1,110 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "SignalUtility.hpp"
+
+#include <Pothos/Exception.hpp>
+#include <Pothos/Object.hpp>
+
+#include <arrayfire.h>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+// Zeroth-order modified Bessel function of the first kind, by its power
+// series, which converges quickly for the betas used in practice.
+static double besselI0(double x)
+{
+    const double quarterXSquared = (x * x) / 4.0;
+
+    double sum = 1.0;
+    double term = 1.0;
+    for(size_t k = 1; k < 64; ++k)
+    {
+        term *= quarterXSquared / static_cast<double>(k * k);
+        sum += term;
+
+        if(term < (sum * 1e-16)) break;
+    }
+
+    return sum;
+}
+
+size_t nextPowerOfTwo(size_t num)
+{
+    size_t ret = 1;
+    while(ret < num) ret <<= 1;
+
+    return ret;
+}
+
+af::array getOverlappedFrames(
+    const af::array& afSignal,
+    size_t frameSize,
+    size_t hopSize,
+    size_t numFrames)
+{
+    // Gather every frame with a single index array instead of one copy per
+    // frame.
+    const auto afFrameOffsets = af::range(af::dim4(frameSize, numFrames), 0, ::u32);
+    const auto afFrameStarts = af::range(af::dim4(frameSize, numFrames), 1, ::u32) * static_cast<unsigned>(hopSize);
+
+    return af::moddims(
+               af::flat(afSignal)(af::flat(afFrameOffsets + afFrameStarts)),
+               static_cast<dim_t>(frameSize),
+               static_cast<dim_t>(numFrames));
+}
+
+af::array getWindow(
+    const std::string& window,
+    size_t length,
+    double kaiserBeta,
+    af::dtype afDType)
+{
+    if(0 == length)
+    {
+        throw Pothos::InvalidArgumentException("Window length must be > 0.");
+    }
+
+    std::vector<double> coeffs(length);
+    const double N = static_cast<double>(length);
+    const double twoPi = 2.0 * std::acos(-1.0);
+
+    for(size_t n = 0; n < length; ++n)
+    {
+        const double phase = twoPi * static_cast<double>(n) / N;
+
+        if("Rectangular" == window)
+        {
+            coeffs[n] = 1.0;
+        }
+        else if("Hann" == window)
+        {
+            coeffs[n] = 0.5 - (0.5 * std::cos(phase));
+        }
+        else if("Hamming" == window)
+        {
+            coeffs[n] = 0.54 - (0.46 * std::cos(phase));
+        }
+        else if("BlackmanHarris" == window)
+        {
+            coeffs[n] = 0.35875
+                      - (0.48829 * std::cos(phase))
+                      + (0.14128 * std::cos(2.0 * phase))
+                      - (0.01168 * std::cos(3.0 * phase));
+        }
+        else if("Kaiser" == window)
+        {
+            const double ratio = (2.0 * static_cast<double>(n) / N) - 1.0;
+            coeffs[n] = besselI0(kaiserBeta * std::sqrt(1.0 - (ratio * ratio))) / besselI0(kaiserBeta);
+        }
+        else throw Pothos::InvalidArgumentException("Invalid window", window);
+    }
+
+    const auto afWindowDType = (::c32 == afDType) ? ::f32
+                             : (::c64 == afDType) ? ::f64
+                             : afDType;
+
+    return Pothos::Object(coeffs).convert<af::array>().as(afWindowDType);
+}
@@ -0,0 +1,35 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <arrayfire.h>
+
+#include <cstddef>
+#include <string>
+
+//
+// Shared helpers for streaming signal processing blocks
+//
+
+size_t nextPowerOfTwo(size_t num);
+
+// Returns a frameSize x numFrames array whose columns are the given signal's
+// frames, each starting hopSize elements after the previous one. The signal
+// must have at least ((numFrames-1)*hopSize + frameSize) elements.
+af::array getOverlappedFrames(
+    const af::array& afSignal,
+    size_t frameSize,
+    size_t hopSize,
+    size_t numFrames);
+
+// Returns a periodic (DFT-even) window of the given length, for spectral
+// analysis. The window is real, with the precision of the given type, so
+// multiplying frames of that type by it doesn't promote them. Valid windows
+// are "Rectangular", "Hann", "Hamming", "BlackmanHarris", and "Kaiser", which
+// uses the given beta.
+af::array getWindow(
+    const std::string& window,
+    size_t length,
+    double kaiserBeta,
+    af::dtype afDType);
@@ -173,6 +173,8 @@ class OneArrayStatsBlock: public ArrayFireBlock
                 return;
             }
 
+            this->configArrayFire();
+
             auto afArray = this->getInputPortAsAfArray(0);
             auto afLabelValues = _func(afArray.as(::f64), defaultDim);
             if(1 != afLabelValues.elements())
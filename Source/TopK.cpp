@@ -96,6 +96,8 @@ class TopK: public ArrayFireBlock
                 return;
             }
 
+            this->configArrayFire();
+
             auto afArray = this->getInputPortAsAfArray(0);
 
             af::array vals, _;
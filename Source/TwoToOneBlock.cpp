@@ -1,4 +1,4 @@
-// Copyright (c) 2019-2020 Nicholas Corgan
+// Copyright (c) 2019-2020,2023 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include "TwoToOneBlock.hpp"
@@ -93,15 +93,22 @@ TwoToOneBlock::TwoToOneBlock(
     this->setupInput(0, inputDType, _domain);
     this->setupInput(1, inputDType, _domain);
     this->setupOutput(0, outputDType, _domain);
+
+    this->registerPipeliningCalls();
+
+    this->registerBatchingCalls();
 }
 
 TwoToOneBlock::~TwoToOneBlock() {}
 
 void TwoToOneBlock::work()
 {
-    const size_t elems = this->workInfo().minAllElements;
+    this->configArrayFire();
+
+    const size_t elems = this->getBatchElements(this->workInfo().minAllElements);
     if(0 == elems)
     {
+        this->flushPipelinedOutputs();
         return;
     }
 
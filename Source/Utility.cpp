@@ -215,6 +215,44 @@ Pothos::Object afArrayToStdVector(const af::array& afArray)
     return ret;
 }
 
+af::array joinAfArrays(
+    int dim,
+    const std::vector<af::array>& afArrays)
+{
+    // ArrayFire only joins up to 10 arrays at once.
+    static constexpr size_t MaxJoinSize = 10;
+
+    if(afArrays.empty())
+    {
+        throw Pothos::InvalidArgumentException("No arrays to join.");
+    }
+    else if(1 == afArrays.size()) return afArrays[0];
+
+    std::vector<af::array> joinedAfArrays;
+    for(size_t start = 0; start < afArrays.size(); start += MaxJoinSize)
+    {
+        const size_t count = std::min(MaxJoinSize, afArrays.size()-start);
+
+        std::vector<af_array> afArrayHandles;
+        for(size_t i = start; i < (start+count); ++i) afArrayHandles.emplace_back(afArrays[i].get());
+
+        af_array joinedHandle = nullptr;
+        af_err err = ::af_join_many(
+                         &joinedHandle,
+                         dim,
+                         static_cast<unsigned>(count),
+                         afArrayHandles.data());
+        if(AF_SUCCESS != err)
+        {
+            throw Pothos::RuntimeException(::af_err_to_string(err));
+        }
+
+        joinedAfArrays.emplace_back(joinedHandle);
+    }
+
+    return joinAfArrays(dim, joinedAfArrays);
+}
+
 #if defined(__GNUG__) || defined(__clang__) || defined(_MSC_VER)
 
 #if defined(__GNUG__) || defined(__clang__)
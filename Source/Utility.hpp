@@ -171,6 +171,11 @@ af::array getArrayFromSingleElement(
 
 Pothos::Object afArrayToStdVector(const af::array& afArray);
 
+// Unlike af::join(), this supports any number of arrays.
+af::array joinAfArrays(
+    int dim,
+    const std::vector<af::array>& afArrays);
+
 //
 // ArrayFire requires taps to be specific types for different inputs.
 //
@@ -0,0 +1,544 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "ArrayFireBlock.hpp"
+#include "FFTPlanCache.hpp"
+#include "SignalUtility.hpp"
+#include "Utility.hpp"
+
+#include <Pothos/Exception.hpp>
+#include <Pothos/Framework.hpp>
+#include <Pothos/Object.hpp>
+
+#include <arrayfire.h>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+static constexpr size_t DefaultMaxFramesPerCall = 64;
+static constexpr size_t DefaultNumAverages = 16;
+static constexpr double DefaultAlpha = 0.1;
+static constexpr double DefaultKaiserBeta = 8.6;
+
+static const std::string DefaultAveraging = "Linear";
+static const std::string DefaultWindow = "Hann";
+
+//
+// Block class
+//
+
+template <typename In, typename Out>
+class WelchPSDBlock: public ArrayFireBlock
+{
+    public:
+        using InType = In;
+        using OutType = Out;
+        using Class = WelchPSDBlock<In, Out>;
+
+        WelchPSDBlock(
+            const std::string& device,
+            size_t dtypeDims,
+            size_t numBins,
+            size_t hopSize
+        ):
+            ArrayFireBlock(device, DeviceOpClass::FFT),
+            _numBins(numBins),
+            _hopSize(hopSize),
+            _averaging(DefaultAveraging),
+            _numAverages(DefaultNumAverages),
+            _alpha(DefaultAlpha),
+            _decibels(false),
+            _window(DefaultWindow),
+            _kaiserBeta(DefaultKaiserBeta),
+            _maxFramesPerCall(DefaultMaxFramesPerCall),
+            _numAccumulated(0)
+        {
+            if(0 == _numBins)
+            {
+                throw Pothos::InvalidArgumentException("numBins must be > 0.");
+            }
+            if((0 == _hopSize) || (_hopSize > _numBins))
+            {
+                throw Pothos::InvalidArgumentException("hopSize must be in the range [1, numBins].");
+            }
+
+            static const Pothos::DType inDType(typeid(InType));
+            static const Pothos::DType outDType(typeid(OutType));
+
+            this->setupInput(0, Pothos::DType::fromDType(inDType, dtypeDims), _domain);
+            this->setupOutput(0, Pothos::DType::fromDType(outDType, dtypeDims), _domain);
+
+            this->_updateWindow();
+
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, numBins));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, hopSize));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, averaging));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, setAveraging));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, numAverages));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, setNumAverages));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, alpha));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, setAlpha));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, decibels));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, setDecibels));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, window));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, setWindow));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, kaiserBeta));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, setKaiserBeta));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, maxFramesPerCall));
+            this->registerCall(this, POTHOS_FCN_TUPLE(Class, setMaxFramesPerCall));
+            this->registerPipeliningCalls();
+            this->registerBatchingCalls();
+        }
+
+        virtual ~WelchPSDBlock() = default;
+
+        void activate() override
+        {
+            ArrayFireBlock::activate();
+
+            _afPending = af::array();
+            this->_resetAverage();
+            this->_reservePlans();
+        }
+
+        void deactivate() override
+        {
+            ArrayFireBlock::deactivate();
+
+            _planReservation.release();
+        }
+
+        size_t numBins() const
+        {
+            return _numBins;
+        }
+
+        size_t hopSize() const
+        {
+            return _hopSize;
+        }
+
+        std::string averaging() const
+        {
+            return _averaging;
+        }
+
+        void setAveraging(const std::string& averaging)
+        {
+            if(("Linear" != averaging) && ("Exponential" != averaging) && ("MaxHold" != averaging))
+            {
+                throw Pothos::InvalidArgumentException("Invalid averaging", averaging);
+            }
+
+            _averaging = averaging;
+            this->_resetAverage();
+        }
+
+        size_t numAverages() const
+        {
+            return _numAverages;
+        }
+
+        void setNumAverages(size_t numAverages)
+        {
+            if(0 == numAverages)
+            {
+                throw Pothos::InvalidArgumentException("numAverages must be > 0.");
+            }
+
+            _numAverages = numAverages;
+            this->_resetAverage();
+        }
+
+        double alpha() const
+        {
+            return _alpha;
+        }
+
+        void setAlpha(double alpha)
+        {
+            if((alpha <= 0.0) || (alpha > 1.0))
+            {
+                throw Pothos::InvalidArgumentException("alpha must be in the range (0, 1].");
+            }
+
+            _alpha = alpha;
+        }
+
+        bool decibels() const
+        {
+            return _decibels;
+        }
+
+        void setDecibels(bool decibels)
+        {
+            _decibels = decibels;
+        }
+
+        std::string window() const
+        {
+            return _window;
+        }
+
+        void setWindow(const std::string& window)
+        {
+            const auto oldWindow = _window;
+            _window = window;
+
+            try
+            {
+                this->_updateWindow();
+            }
+            catch(...)
+            {
+                _window = oldWindow;
+                throw;
+            }
+        }
+
+        double kaiserBeta() const
+        {
+            return _kaiserBeta;
+        }
+
+        void setKaiserBeta(double kaiserBeta)
+        {
+            if(kaiserBeta < 0.0)
+            {
+                throw Pothos::InvalidArgumentException("kaiserBeta must be >= 0.");
+            }
+
+            _kaiserBeta = kaiserBeta;
+            this->_updateWindow();
+        }
+
+        size_t maxFramesPerCall() const
+        {
+            return _maxFramesPerCall;
+        }
+
+        void setMaxFramesPerCall(size_t maxFramesPerCall)
+        {
+            if(0 == maxFramesPerCall)
+            {
+                throw Pothos::InvalidArgumentException("maxFramesPerCall must be > 0.");
+            }
+
+            _maxFramesPerCall = maxFramesPerCall;
+            if(this->isActive()) this->_reservePlans();
+        }
+
+        void work() override
+        {
+            // The thread may have changed since the block was created, so make sure
+            // the backend and device still match.
+            this->configArrayFire();
+
+            // Only take as many frames as can complete the averages that fit
+            // in the output. Pending samples are always fewer than numBins.
+            const size_t maxSpectra = this->output(0)->elements() / _numBins;
+            const size_t maxFrames = std::min(((maxSpectra + 1) * _numAverages) - _numAccumulated - 1, _maxFramesPerCall);
+            const size_t maxInputs = (maxFrames > 0) ? (((maxFrames-1) * _hopSize) + _numBins - static_cast<size_t>(_afPending.elements())) : 0;
+
+            const size_t elems = this->getBatchElements(std::min(this->input(0)->elements(), maxInputs));
+            if(0 == elems)
+            {
+                this->flushPipelinedOutputs();
+                return;
+            }
+
+            auto afInput = this->consumeInputPortAsAfArray(0, elems);
+            auto afSignal = _afPending.isempty() ? afInput : af::join(0, _afPending, afInput);
+
+            const size_t signalLength = afSignal.elements();
+            const size_t numFrames = (signalLength >= _numBins) ? (((signalLength - _numBins) / _hopSize) + 1) : 0;
+            if(numFrames > 0)
+            {
+                auto afPower = this->_getPowerSpectra(getOverlappedFrames(afSignal, _numBins, _hopSize, numFrames), numFrames);
+
+                // Split the frames where each average completes, and output
+                // all completed averages in one transfer.
+                std::vector<af::array> afSpectra;
+                for(size_t frame = 0; frame < numFrames;)
+                {
+                    const size_t count = std::min(numFrames - frame, _numAverages - _numAccumulated);
+                    this->_accumulate(afPower(
+                        af::span,
+                        af::seq(static_cast<double>(frame), static_cast<double>(frame + count - 1))));
+
+                    frame += count;
+                    _numAccumulated += count;
+                    if(_numAverages == _numAccumulated)
+                    {
+                        afSpectra.emplace_back(this->_getAverage());
+
+                        _numAccumulated = 0;
+                        if("Exponential" != _averaging) _afAccumulator = af::array();
+                    }
+                }
+
+                if(!afSpectra.empty()) this->produceFromAfArray(0, joinAfArrays(0, afSpectra));
+            }
+
+            // Keep everything from the start of the next frame.
+            const size_t nextFrameStart = numFrames * _hopSize;
+            if(nextFrameStart < signalLength)
+            {
+                _afPending = afSignal(af::seq(
+                                 static_cast<double>(nextFrameStart),
+                                 static_cast<double>(signalLength - 1)));
+                _afPending.eval();
+            }
+            else _afPending = af::array();
+        }
+
+    private:
+        size_t _numBins;
+        size_t _hopSize;
+
+        std::string _averaging;
+        size_t _numAverages;
+        double _alpha;
+        bool _decibels;
+
+        std::string _window;
+        double _kaiserBeta;
+        af::array _afWindow;
+
+        size_t _maxFramesPerCall;
+
+        // Input samples from the start of the next frame, kept on the device.
+        af::array _afPending;
+
+        // The running sum, maximum, or exponential average, kept on the device.
+        af::array _afAccumulator;
+        size_t _numAccumulated;
+
+        FFTPlanReservation _planReservation;
+
+        void _reservePlans()
+        {
+            static const Pothos::DType inDType(typeid(InType));
+
+            _planReservation.reserve(
+                _afBackend,
+                _afDevice,
+                {getC2CFFTPlanKey(Pothos::Object(inDType).convert<af::dtype>(), _numBins, _maxFramesPerCall)});
+        }
+
+        void _updateWindow()
+        {
+            static const Pothos::DType inDType(typeid(InType));
+
+            this->configArrayFire();
+
+            _afWindow = getWindow(
+                            _window,
+                            _numBins,
+                            _kaiserBeta,
+                            Pothos::Object(inDType).convert<af::dtype>());
+        }
+
+        void _resetAverage()
+        {
+            _afAccumulator = af::array();
+            _numAccumulated = 0;
+        }
+
+        // One |X|^2 column per frame
+        af::array _getPowerSpectra(const af::array& afFrames, size_t numFrames)
+        {
+            auto afWindowed = afFrames * af::tile(_afWindow, 1, static_cast<unsigned>(numFrames));
+            auto afSpectrum = af::fft(IsComplex<InType>::value ? afWindowed : af::complex(afWindowed));
+
+            return (af::real(afSpectrum) * af::real(afSpectrum)) + (af::imag(afSpectrum) * af::imag(afSpectrum));
+        }
+
+        void _accumulate(const af::array& afPower)
+        {
+            const size_t numFrames = afPower.dims(1);
+
+            if("Linear" == _averaging)
+            {
+                auto afSum = af::sum(afPower, 1);
+                _afAccumulator = _afAccumulator.isempty() ? afSum : (_afAccumulator + afSum);
+            }
+            else if("MaxHold" == _averaging)
+            {
+                auto afMax = af::max(afPower, 1);
+                _afAccumulator = _afAccumulator.isempty() ? afMax : af::max(_afAccumulator, afMax);
+            }
+            else
+            {
+                // Unroll avg = (alpha * frame) + ((1 - alpha) * avg) over all
+                // frames as one weighted sum, seeding with the first frame.
+                size_t firstFrame = 0;
+                if(_afAccumulator.isempty())
+                {
+                    _afAccumulator = afPower(af::span, 0);
+                    firstFrame = 1;
+                }
+
+                const size_t numRemaining = numFrames - firstFrame;
+                if(numRemaining > 0)
+                {
+                    std::vector<double> weights(numRemaining);
+                    for(size_t frame = 0; frame < numRemaining; ++frame)
+                    {
+                        weights[frame] = _alpha * std::pow(1.0 - _alpha, static_cast<double>(numRemaining - 1 - frame));
+                    }
+                    const auto afWeights = Pothos::Object(weights).convert<af::array>().as(afPower.type());
+
+                    _afAccumulator = (_afAccumulator * std::pow(1.0 - _alpha, static_cast<double>(numRemaining)))
+                                   + af::matmul(
+                                         afPower(af::span, af::seq(static_cast<double>(firstFrame), static_cast<double>(numFrames - 1))),
+                                         afWeights);
+                }
+            }
+
+            _afAccumulator.eval();
+        }
+
+        af::array _getAverage()
+        {
+            auto afAverage = ("Linear" == _averaging) ? (_afAccumulator / static_cast<double>(_numAverages))
+                                                      : _afAccumulator;
+
+            return _decibels ? (10.0 * af::log10(afAverage)) : afAverage;
+        }
+};
+
+//
+// Factory
+//
+
+static Pothos::Block* makeWelchPSD(
+    const std::string& device,
+    const Pothos::DType& dtype,
+    size_t numBins,
+    size_t hopSize)
+{
+    #define __ifTypeDeclareFactory(InType, FloatType) \
+        if(Pothos::DType::fromDType(dtype, 1) == Pothos::DType(typeid(InType))) \
+            return new WelchPSDBlock<InType, FloatType>(device, dtype.dimension(), numBins, hopSize);
+    #define ifTypeDeclareFactory(FloatType) \
+        __ifTypeDeclareFactory(FloatType, FloatType) \
+        __ifTypeDeclareFactory(std::complex<FloatType>, FloatType)
+
+    ifTypeDeclareFactory(float)
+    ifTypeDeclareFactory(double)
+    #undef ifTypeDeclareFactory
+    #undef __ifTypeDeclareFactory
+
+    throw Pothos::InvalidArgumentException(
+              "Unsupported type.",
+              dtype.name());
+}
+
+//
+// Block registration
+//
+
+/*
+ * |PothosDoc Welch PSD (GPU)
+ *
+ * Averages the power spectra (|X|^2) of windowed, overlapping frames of the input,
+ * as in Welch's method. A new frame starts every <b>hopSize</b> samples, and the
+ * spectra are accumulated on the device. An averaged spectrum of <b>numBins</b>
+ * elements is only output every <b>numAverages</b> frames, so little data leaves
+ * the device.
+ *
+ * The averaging can be one of the following:
+ * <ul>
+ * <li><b>Linear:</b> the mean of the last <b>numAverages</b> frames.</li>
+ * <li><b>Exponential:</b> a running average, where each frame has a weight of <b>alpha</b>.</li>
+ * <li><b>Max Hold:</b> the per-bin maximum over the last <b>numAverages</b> frames.</li>
+ * </ul>
+ *
+ * |category /GPU/Signal
+ * |category /FFT/GPU
+ * |keywords array signal fft psd power spectrum spectral density welch average window
+ * |factory /gpu/signal/welch_psd(device,dtype,numBins,hopSize)
+ * |setter setAveraging(averaging)
+ * |setter setNumAverages(numAverages)
+ * |setter setAlpha(alpha)
+ * |setter setDecibels(decibels)
+ * |setter setWindow(window)
+ * |setter setKaiserBeta(kaiserBeta)
+ * |setter setMaxFramesPerCall(maxFramesPerCall)
+ *
+ * |param device[Device] Device to use for processing.
+ * |default "Auto"
+ *
+ * |param dtype[Data Type] The input's data type. The output is real, with the same precision.
+ * |widget DTypeChooser(float=1,cfloat=1,dim=1)
+ * |default "complex_float64"
+ * |preview disable
+ *
+ * |param numBins[Num FFT Bins] The number of bins per FFT, which is also the window length.
+ * |default 1024
+ * |option 256
+ * |option 512
+ * |option 1024
+ * |option 2048
+ * |option 4096
+ * |option 8192
+ * |widget ComboBox(editable=true)
+ * |preview enable
+ *
+ * |param hopSize[Hop Size] The number of samples between the starts of consecutive frames.
+ * Must be no larger than <b>numBins</b>.
+ * |default 512
+ * |widget SpinBox(minimum=1)
+ * |preview enable
+ *
+ * |param averaging[Averaging] How to combine the frames' power spectra.
+ * |widget ComboBox(editable=false)
+ * |option [Linear] "Linear"
+ * |option [Exponential] "Exponential"
+ * |option [Max Hold] "MaxHold"
+ * |default "Linear"
+ * |preview enable
+ *
+ * |param numAverages[Num Averages] The number of frames per output spectrum.
+ * |widget SpinBox(minimum=1)
+ * |default 16
+ * |preview enable
+ *
+ * |param alpha[Alpha] The weight of each new frame for exponential averaging.
+ * |widget DoubleSpinBox(minimum=0.0,maximum=1.0,step=0.01,decimals=3)
+ * |default 0.1
+ * |preview disable
+ *
+ * |param decibels[Decibels?] Whether to output the averaged power in dB.
+ * |widget ToggleSwitch(on="True",off="False")
+ * |default false
+ * |preview disable
+ *
+ * |param window[Window] The window applied to each frame before the FFT.
+ * |widget ComboBox(editable=false)
+ * |option [Rectangular] "Rectangular"
+ * |option [Hann] "Hann"
+ * |option [Hamming] "Hamming"
+ * |option [Blackman-Harris] "BlackmanHarris"
+ * |option [Kaiser] "Kaiser"
+ * |default "Hann"
+ * |preview enable
+ *
+ * |param kaiserBeta[Kaiser Beta] The shape parameter for the Kaiser window.
+ * |widget DoubleSpinBox(minimum=0.0)
+ * |default 8.6
+ * |preview disable
+ *
+ * |param maxFramesPerCall[Max Frames Per Call] The most frames to transform at once.
+ * |widget SpinBox(minimum=1)
+ * |default 64
+ * |preview disable
+ */
+static Pothos::BlockRegistry registerWelchPSD(
+    "/gpu/signal/welch_psd",
+    Pothos::Callable(&makeWelchPSD));
@@ -9,9 +9,11 @@
 #include <Pothos/Proxy.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <complex>
 #include <cstring>
 #include <iostream>
+#include <string>
 #include <type_traits>
 #include <vector>
 
@@ -458,3 +460,66 @@ POTHOS_TEST_BLOCK("/gpu/tests", test_scalar_arithmetic)
     testScalarArithmetic<std::complex<float>>();
     testScalarArithmetic<std::complex<double>>();
 }
+
+// Enough channels to need more than one join, with the inputs both on the
+// host and already on the device.
+POTHOS_TEST_BLOCK("/gpu/tests", test_array_arithmetic_many_channels)
+{
+    constexpr size_t numInputs = 16;
+    const std::string type = "float64";
+
+    for(bool inputsOnDevice: {false, true})
+    {
+        std::cout << "Inputs on device: " << std::boolalpha << inputsOnDevice << std::endl;
+
+        auto arithmetic = Pothos::BlockRegistry::make(
+                              "/gpu/array/arithmetic",
+                              "Auto",
+                              "Add",
+                              type,
+                              numInputs);
+
+        std::vector<double> expectedOutputs(GPUTests::TestInputLength, 0.0);
+        std::vector<Pothos::Proxy> feeders(numInputs);
+        std::vector<Pothos::Proxy> absBlocks(numInputs);
+        for(size_t input = 0; input < numInputs; ++input)
+        {
+            auto inputs = GPUTests::getTestInputs(type);
+
+            const auto* inputBuffer = inputs.as<const double*>();
+            for(size_t elem = 0; elem < inputs.elements(); ++elem)
+            {
+                expectedOutputs[elem] += inputsOnDevice ? std::abs(inputBuffer[elem]) : inputBuffer[elem];
+            }
+
+            feeders[input] = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+            feeders[input].call("feedBuffer", inputs);
+
+            absBlocks[input] = Pothos::BlockRegistry::make("/gpu/arith/abs", "Auto", type);
+        }
+
+        auto sink = Pothos::BlockRegistry::make("/blocks/collector_sink", type);
+
+        {
+            Pothos::Topology topology;
+
+            for(size_t input = 0; input < numInputs; ++input)
+            {
+                if(inputsOnDevice)
+                {
+                    topology.connect(feeders[input], 0, absBlocks[input], 0);
+                    topology.connect(absBlocks[input], 0, arithmetic, input);
+                }
+                else topology.connect(feeders[input], 0, arithmetic, input);
+            }
+            topology.connect(arithmetic, 0, sink, 0);
+
+            topology.commit();
+            POTHOS_TEST_TRUE(topology.waitInactive(0.05));
+        }
+
+        GPUTests::testBufferChunk(
+            GPUTests::stdVectorToBufferChunk(expectedOutputs),
+            sink.call<Pothos::BufferChunk>("getBuffer"));
+    }
+}
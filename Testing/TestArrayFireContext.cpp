@@ -0,0 +1,53 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "ArrayFireContext.hpp"
+#include "DeviceCache.hpp"
+#include "TestUtility.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Object.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <arrayfire.h>
+
+#include <iostream>
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_arrayfire_context)
+{
+    for(const auto& backend: getAvailableBackends())
+    {
+        std::cout << "Backend: " << Pothos::Object(backend).convert<std::string>() << std::endl;
+
+        setThreadArrayFireContext(backend, 0);
+        POTHOS_TEST_EQUAL(backend, af::getActiveBackend());
+        POTHOS_TEST_EQUAL(0, af::getDevice());
+
+        // Nothing changes, so nothing should be switched.
+        resetArrayFireContextSwitchCount();
+        for(size_t i = 0; i < 10; ++i)
+        {
+            setThreadArrayFireContext(backend, 0);
+            setThreadArrayFireBackend(backend);
+        }
+        POTHOS_TEST_EQUAL(0, GPUTests::getAndCallPlugin<size_t>("/gpu/context/switch_count"));
+    }
+
+    const auto backends = getAvailableBackends();
+    if(backends.size() > 1)
+    {
+        setThreadArrayFireContext(backends[0], 0);
+        resetArrayFireContextSwitchCount();
+
+        setThreadArrayFireContext(backends[1], 0);
+        POTHOS_TEST_EQUAL(backends[1], af::getActiveBackend());
+        POTHOS_TEST_GE(getArrayFireContextSwitchCount(), 1);
+
+        // Each backend remembers its own device, so switching back shouldn't
+        // need another device switch.
+        resetArrayFireContextSwitchCount();
+        setThreadArrayFireContext(backends[0], 0);
+        POTHOS_TEST_EQUAL(backends[0], af::getActiveBackend());
+        POTHOS_TEST_EQUAL(1, getArrayFireContextSwitchCount());
+    }
+}
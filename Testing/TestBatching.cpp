@@ -0,0 +1,124 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "TestUtility.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static constexpr size_t NumFeeds = 16;
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_batching_one_input)
+{
+    const std::string type = "float64";
+
+    // Test batches smaller than, equal to, and larger than the whole stream,
+    // the last of which relies on the latency bound.
+    const std::vector<size_t> minBatchSizes = {0, 1000, 4096, (NumFeeds*GPUTests::TestInputLength)+1};
+
+    for(size_t minBatchElements: minBatchSizes)
+    {
+        std::cout << "Testing minimum batch size " << minBatchElements << "..." << std::endl;
+
+        auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+        auto abs = Pothos::BlockRegistry::make("/gpu/arith/abs", "Auto", type);
+        auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", type);
+
+        abs.call("setMinBatchElements", minBatchElements);
+        abs.call("setMaxBatchLatency", 0.001);
+        POTHOS_TEST_EQUAL(minBatchElements, abs.call<size_t>("minBatchElements"));
+        POTHOS_TEST_EQUAL(0.001, abs.call<double>("maxBatchLatency"));
+
+        std::vector<double> expectedOutputs;
+        for(size_t feed = 0; feed < NumFeeds; ++feed)
+        {
+            auto inputs = GPUTests::getTestInputs(type);
+            const auto* inputBuffer = inputs.as<const double*>();
+            for(size_t elem = 0; elem < inputs.elements(); ++elem)
+            {
+                expectedOutputs.emplace_back(std::abs(inputBuffer[elem]));
+            }
+
+            feeder.call("feedBuffer", inputs);
+        }
+
+        {
+            Pothos::Topology topology;
+
+            topology.connect(feeder, 0, abs, 0);
+            topology.connect(abs, 0, collector, 0);
+
+            topology.commit();
+            POTHOS_TEST_TRUE(topology.waitInactive(0.05));
+        }
+
+        GPUTests::testBufferChunk(
+            GPUTests::stdVectorToBufferChunk(expectedOutputs),
+            collector.call<Pothos::BufferChunk>("getBuffer"));
+    }
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_batching_two_inputs)
+{
+    const std::string type = "float64";
+    constexpr size_t MinBatchElements = 4096;
+
+    auto feeder0 = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+    auto feeder1 = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+    auto hypot = Pothos::BlockRegistry::make("/gpu/arith/hypot", "Auto", type);
+    auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", type);
+
+    hypot.call("setMinBatchElements", MinBatchElements);
+
+    std::vector<double> expectedOutputs;
+    for(size_t feed = 0; feed < NumFeeds; ++feed)
+    {
+        auto inputs0 = GPUTests::getTestInputs(type);
+        auto inputs1 = GPUTests::getTestInputs(type);
+        const auto* inputBuffer0 = inputs0.as<const double*>();
+        const auto* inputBuffer1 = inputs1.as<const double*>();
+        for(size_t elem = 0; elem < inputs0.elements(); ++elem)
+        {
+            expectedOutputs.emplace_back(std::hypot(inputBuffer0[elem], inputBuffer1[elem]));
+        }
+
+        feeder0.call("feedBuffer", inputs0);
+        feeder1.call("feedBuffer", inputs1);
+    }
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect(feeder0, 0, hypot, 0);
+        topology.connect(feeder1, 0, hypot, 1);
+        topology.connect(hypot, 0, collector, 0);
+
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive(0.05));
+    }
+
+    GPUTests::testBufferChunk(
+        GPUTests::stdVectorToBufferChunk(expectedOutputs),
+        collector.call<Pothos::BufferChunk>("getBuffer"));
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_batching_requires_support)
+{
+    const std::string type = "float64";
+
+    // This block's work() doesn't batch, so it shouldn't accept a batch size
+    // it would ignore.
+    auto max = Pothos::BlockRegistry::make("/gpu/algorithm/max", "Auto", type);
+    POTHOS_TEST_THROWS(
+        max.call("setMinBatchElements", 4096),
+        Pothos::ProxyExceptionMessage);
+    POTHOS_TEST_THROWS(
+        max.call("setMaxBatchLatency", 0.001),
+        Pothos::ProxyExceptionMessage);
+}
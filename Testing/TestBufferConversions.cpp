@@ -1,6 +1,7 @@
 // Copyright (c) 2019-2020 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include "ArrayFireContext.hpp"
 #include "BufferConversions.hpp"
 #include "DeviceCache.hpp"
 #include "Utility.hpp"
@@ -101,7 +102,7 @@ POTHOS_TEST_BLOCK("/gpu/tests", test_af_array_conversion)
 
     for(const auto& backend: getAvailableBackends())
     {
-        af::setBackend(backend);
+        setThreadArrayFireBackend(backend);
         std::cout << "Backend: " << Pothos::Object(backend).convert<std::string>() << std::endl;
 
         for(const auto& dtype: getAllDTypes())
@@ -117,7 +118,7 @@ POTHOS_TEST_BLOCK("/gpu/tests", test_af_arrayproxy_conversion)
 
     for(const auto& backend: getAvailableBackends())
     {
-        af::setBackend(backend);
+        setThreadArrayFireBackend(backend);
         std::cout << "Backend: " << Pothos::Object(backend).convert<std::string>() << std::endl;
 
         for(const auto& dtype: getAllDTypes())
@@ -133,7 +134,7 @@ POTHOS_TEST_BLOCK("/gpu/tests", test_std_vector_conversion)
 
     for(const auto& backend: getAvailableBackends())
     {
-        af::setBackend(backend);
+        setThreadArrayFireBackend(backend);
         std::cout << "Backend: " << Pothos::Object(backend).convert<std::string>() << std::endl;
 
         testStdVectorToAfArrayConversion<float>(::f32);
@@ -0,0 +1,75 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "DeviceCache.hpp"
+#include "TestUtility.hpp"
+#include "Utility.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <arrayfire.h>
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_cpu_zero_copy_input)
+{
+    if(!doesVectorContainValue(getAvailableBackends(), ::AF_BACKEND_CPU))
+    {
+        std::cout << "Skipping test. CPU backend not available." << std::endl;
+        return;
+    }
+
+    const std::string type = "float64";
+    constexpr size_t NumFeeds = 16;
+
+    const auto cpuDevice = getAnyDeviceWithBackend(::AF_BACKEND_CPU);
+
+    auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+    auto sqrt = Pothos::BlockRegistry::make("/gpu/arith/sqrt", cpuDevice, type);
+    auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", type);
+
+    // Always go through ArrayFire, and count any host-to-device copies.
+    sqrt.call("setHostFallbackThreshold", 0);
+    sqrt.call("setProfilingEnabled", true);
+
+    // Feed many buffers so wrapped buffers are released and recycled
+    // while the block runs.
+    std::vector<double> expectedOutputs;
+    for(size_t feed = 0; feed < NumFeeds; ++feed)
+    {
+        auto inputs = GPUTests::getTestInputs(type);
+        auto* inputBuffer = inputs.as<double*>();
+        for(size_t elem = 0; elem < inputs.elements(); ++elem)
+        {
+            inputBuffer[elem] = std::abs(inputBuffer[elem]);
+            expectedOutputs.emplace_back(std::sqrt(inputBuffer[elem]));
+        }
+
+        feeder.call("feedBuffer", inputs);
+    }
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect(feeder, 0, sqrt, 0);
+        topology.connect(sqrt, 0, collector, 0);
+
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive(0.01));
+    }
+
+    GPUTests::testBufferChunk(
+        GPUTests::stdVectorToBufferChunk(expectedOutputs),
+        collector.call<Pothos::BufferChunk>("getBuffer"));
+
+    // Every input should have been wrapped rather than copied.
+    const auto transferStats = nlohmann::json::parse(sqrt.call<std::string>("transferStats"));
+    POTHOS_TEST_EQUAL(0, transferStats["Host to Device"]["Transfers"].get<size_t>());
+}
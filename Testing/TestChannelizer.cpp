@@ -0,0 +1,108 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "TestUtility.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Shift each channel to baseband, filter, and decimate, with zero initial
+// state, as if the whole stream was channelized at once.
+static std::vector<Pothos::BufferChunk> getExpectedOutputs(
+    const Pothos::BufferChunk& inputs,
+    const std::vector<double>& taps,
+    size_t numChannels,
+    size_t decimation)
+{
+    const double twoPi = 2.0 * std::acos(-1.0);
+    const auto* in = inputs.as<const std::complex<double>*>();
+    const size_t numInputs = inputs.elements();
+
+    std::vector<Pothos::BufferChunk> outputs;
+    for(size_t chan = 0; chan < numChannels; ++chan)
+    {
+        Pothos::BufferChunk shifted(inputs.dtype, numInputs);
+        for(size_t elem = 0; elem < numInputs; ++elem)
+        {
+            const double phase = -twoPi * static_cast<double>(chan * elem) / numChannels;
+            shifted.as<std::complex<double>*>()[elem] = in[elem] * std::polar(1.0, phase);
+        }
+
+        const auto filtered = GPUTests::getExpectedFIROutputs(shifted, taps);
+
+        std::vector<std::complex<double>> channelOutputs;
+        for(size_t pos = 0; pos < numInputs; pos += decimation)
+        {
+            channelOutputs.emplace_back(filtered.as<const std::complex<double>*>()[pos]);
+        }
+        outputs.emplace_back(GPUTests::stdVectorToBufferChunk(channelOutputs));
+    }
+
+    return outputs;
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_channelizer)
+{
+    const std::string type = "complex_float64";
+    constexpr size_t numChannels = 8;
+
+    std::vector<double> taps;
+    for(size_t tap = 0; tap < 29; ++tap)
+    {
+        taps.emplace_back(GPUTests::getSingleTestInput("float64").convert<double>());
+    }
+
+    for(size_t oversampling: {1, 2})
+    {
+        std::cout << "Oversampling: " << oversampling << std::endl;
+
+        const auto inputs = GPUTests::getTestInputs(type);
+        const auto expectedOutputs = getExpectedOutputs(inputs, taps, numChannels, numChannels / oversampling);
+
+        auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+        auto channelizer = Pothos::BlockRegistry::make(
+                               "/gpu/signal/channelizer",
+                               "Auto",
+                               type,
+                               numChannels,
+                               oversampling);
+        channelizer.call("setTaps", taps);
+
+        std::vector<Pothos::Proxy> collectors;
+        for(size_t chan = 0; chan < numChannels; ++chan)
+        {
+            collectors.emplace_back(Pothos::BlockRegistry::make("/blocks/collector_sink", type));
+        }
+
+        GPUTests::feedBufferInChunks(feeder, inputs, GPUTests::getStreamingChunkLengths());
+
+        {
+            Pothos::Topology topology;
+
+            topology.connect(feeder, 0, channelizer, 0);
+            for(size_t chan = 0; chan < numChannels; ++chan)
+            {
+                topology.connect(channelizer, chan, collectors[chan], 0);
+            }
+
+            topology.commit();
+            POTHOS_TEST_TRUE(topology.waitInactive(0.05));
+        }
+
+        for(size_t chan = 0; chan < numChannels; ++chan)
+        {
+            std::cout << " * Testing channel " << chan << std::endl;
+
+            GPUTests::testBufferChunk(
+                expectedOutputs[chan],
+                collectors[chan].call<Pothos::BufferChunk>("getBuffer"));
+        }
+    }
+}
@@ -0,0 +1,147 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "ArrayFireContext.hpp"
+#include "DeviceBuffer.hpp"
+#include "DeviceCache.hpp"
+#include "TestUtility.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Object.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <arrayfire.h>
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_device_buffer_conversion)
+{
+    constexpr dim_t ArrDim = 128;
+    constexpr dim_t Offset = 32;
+
+    for(const auto& backend: getAvailableBackends())
+    {
+        setThreadArrayFireBackend(backend);
+        std::cout << "Backend: " << Pothos::Object(backend).convert<std::string>() << std::endl;
+
+        const auto afArray = af::randu(ArrDim, ::f32);
+
+        auto deviceBufferChunk = afArrayToDeviceBufferChunk(afArray);
+        POTHOS_TEST_TRUE(isDeviceBufferChunk(deviceBufferChunk));
+        POTHOS_TEST_EQUAL(afArray.bytes(), deviceBufferChunk.length);
+        POTHOS_TEST_EQUAL(ArrDim, static_cast<dim_t>(deviceBufferChunk.elements()));
+
+        // Host buffers should never be mistaken for device buffers.
+        POTHOS_TEST_FALSE(isDeviceBufferChunk(Pothos::BufferChunk("float32", ArrDim)));
+        POTHOS_TEST_FALSE(isDeviceBufferChunk(Pothos::Object(afArray).convert<Pothos::BufferChunk>()));
+
+        auto convertedAfArray = Pothos::Object(deviceBufferChunk).convert<af::array>();
+        POTHOS_TEST_TRUE(af::allTrue<bool>(afArray == convertedAfArray));
+
+        // Partially consumed chunks should map to the remaining elements.
+        auto offsetBufferChunk = deviceBufferChunk;
+        offsetBufferChunk.address += (Offset * offsetBufferChunk.dtype.size());
+        offsetBufferChunk.length -= (Offset * offsetBufferChunk.dtype.size());
+        POTHOS_TEST_TRUE(isDeviceBufferChunk(offsetBufferChunk));
+
+        auto offsetAfArray = Pothos::Object(offsetBufferChunk).convert<af::array>();
+        POTHOS_TEST_EQUAL((ArrDim - Offset), offsetAfArray.elements());
+        POTHOS_TEST_TRUE(af::allTrue<bool>(afArray(af::seq(Offset, ArrDim-1)) == offsetAfArray));
+    }
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_device_buffer_deferred_partial_consume)
+{
+    constexpr dim_t ArrDim = 128;
+    constexpr dim_t FirstPart = 50;
+
+    for(const auto& backend: getAvailableBackends())
+    {
+        setThreadArrayFireBackend(backend);
+        std::cout << "Backend: " << Pothos::Object(backend).convert<std::string>() << std::endl;
+
+        const auto afInput = af::randu(ArrDim, ::f32);
+        const auto afExpected = af::abs(af::cos(afInput));
+        afExpected.eval();
+
+        // The chunk holds an unevaluated expression, consumed in two parts
+        // like a consumer whose output buffer can't take the whole chunk.
+        auto deviceBufferChunk = afArrayToDeviceBufferChunk(af::abs(af::cos(afInput)), true);
+
+        auto firstBufferChunk = deviceBufferChunk;
+        firstBufferChunk.length = FirstPart * firstBufferChunk.dtype.size();
+
+        auto secondBufferChunk = deviceBufferChunk;
+        secondBufferChunk.address += firstBufferChunk.length;
+        secondBufferChunk.length -= firstBufferChunk.length;
+
+        const auto firstAfArray = deviceBufferChunkToAfArray(firstBufferChunk);
+        const auto secondAfArray = deviceBufferChunkToAfArray(secondBufferChunk);
+        POTHOS_TEST_EQUAL(FirstPart, firstAfArray.elements());
+        POTHOS_TEST_EQUAL((ArrDim - FirstPart), secondAfArray.elements());
+
+        POTHOS_TEST_TRUE(af::allTrue<bool>(afExpected(af::seq(0, FirstPart-1)) == firstAfArray));
+        POTHOS_TEST_TRUE(af::allTrue<bool>(afExpected(af::seq(FirstPart, ArrDim-1)) == secondAfArray));
+
+        // A later access of the whole array should see the same values.
+        POTHOS_TEST_TRUE(af::allTrue<bool>(afExpected == deviceBufferChunkToAfArray(deviceBufferChunk)));
+    }
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_device_buffer_chain)
+{
+    const std::string type = "float32";
+
+    auto inputs = GPUTests::getTestInputs(type);
+    const auto* inputBuffer = inputs.as<const float*>();
+
+    std::vector<float> expectedOutputs;
+    for(size_t elem = 0; elem < inputs.elements(); ++elem)
+    {
+        expectedOutputs.emplace_back(std::abs(std::cos(std::abs(inputBuffer[elem]))));
+    }
+
+    // With fusion, the whole chain should be evaluated as one kernel in
+    // the last block.
+    for(bool fusionEnabled: {true, false})
+    {
+        std::cout << "Fusion enabled: " << std::boolalpha << fusionEnabled << std::endl;
+
+        auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+        feeder.call("feedBuffer", inputs);
+
+        // Everything between the feeder and the collector should stay on
+        // the device.
+        auto abs1 = Pothos::BlockRegistry::make("/gpu/arith/abs", "Auto", type);
+        auto cos = Pothos::BlockRegistry::make("/gpu/arith/cos", "Auto", type);
+        auto abs2 = Pothos::BlockRegistry::make("/gpu/arith/abs", "Auto", type);
+
+        for(const auto& block: {abs1, cos, abs2})
+        {
+            block.call("setFusionEnabled", fusionEnabled);
+            POTHOS_TEST_EQUAL(fusionEnabled, block.call<bool>("fusionEnabled"));
+        }
+
+        auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", type);
+
+        {
+            Pothos::Topology topology;
+
+            topology.connect(feeder, 0, abs1, 0);
+            topology.connect(abs1, 0, cos, 0);
+            topology.connect(cos, 0, abs2, 0);
+            topology.connect(abs2, 0, collector, 0);
+
+            topology.commit();
+            POTHOS_TEST_TRUE(topology.waitInactive(0.01));
+        }
+
+        GPUTests::testBufferChunk(
+            GPUTests::stdVectorToBufferChunk(expectedOutputs),
+            collector.call<Pothos::BufferChunk>("getBuffer"));
+    }
+}
@@ -0,0 +1,151 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "TestUtility.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const std::string ExpressionBlockPath = "/gpu/arith/expression";
+static constexpr double Pi = 3.14159265358979323846;
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_expression_one_input)
+{
+    GPUTests::setupTestEnv();
+
+    const std::string type = "float64";
+    constexpr double Scale = 2.5;
+    constexpr double Offset = -3.0;
+
+    auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+    auto expression = Pothos::BlockRegistry::make(
+                          ExpressionBlockPath,
+                          "Auto",
+                          type,
+                          1,
+                          "20*log10(abs(x*scale + offset))");
+    auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", type);
+
+    const std::vector<std::string> expectedVariableNames = {"offset", "scale"};
+    POTHOS_TEST_EQUALV(
+        expectedVariableNames,
+        expression.call<std::vector<std::string>>("variableNames"));
+
+    expression.call("setVariable", "scale", Scale);
+    expression.call("setVariable", "offset", Offset);
+    POTHOS_TEST_EQUAL(Scale, expression.call<double>("variable", "scale"));
+    POTHOS_TEST_EQUAL(Offset, expression.call<double>("variable", "offset"));
+
+    auto inputs = GPUTests::getTestInputs(type);
+    const auto* inputBuffer = inputs.as<const double*>();
+
+    std::vector<double> expectedOutputs;
+    for(size_t elem = 0; elem < inputs.elements(); ++elem)
+    {
+        expectedOutputs.emplace_back(20.0 * std::log10(std::abs((inputBuffer[elem]*Scale) + Offset)));
+    }
+
+    feeder.call("feedBuffer", inputs);
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect(feeder, 0, expression, 0);
+        topology.connect(expression, 0, collector, 0);
+
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive(0.05));
+    }
+
+    GPUTests::testBufferChunk(
+        GPUTests::stdVectorToBufferChunk(expectedOutputs),
+        collector.call<Pothos::BufferChunk>("getBuffer"));
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_expression_two_inputs)
+{
+    GPUTests::setupTestEnv();
+
+    const std::string type = "float32";
+
+    auto feeder0 = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+    auto feeder1 = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+    auto expression = Pothos::BlockRegistry::make(
+                          ExpressionBlockPath,
+                          "Auto",
+                          type,
+                          2,
+                          "hypot(x0, x1) - -x1^2 / (1 + pi)");
+    auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", type);
+
+    POTHOS_TEST_TRUE(expression.call<std::vector<std::string>>("variableNames").empty());
+
+    auto inputs0 = GPUTests::getTestInputs(type);
+    auto inputs1 = GPUTests::getTestInputs(type);
+    const auto* inputBuffer0 = inputs0.as<const float*>();
+    const auto* inputBuffer1 = inputs1.as<const float*>();
+
+    std::vector<float> expectedOutputs;
+    for(size_t elem = 0; elem < inputs0.elements(); ++elem)
+    {
+        const double x0 = inputBuffer0[elem];
+        const double x1 = inputBuffer1[elem];
+        expectedOutputs.emplace_back(float(std::hypot(x0, x1) + ((x1*x1) / (1.0 + Pi))));
+    }
+
+    feeder0.call("feedBuffer", inputs0);
+    feeder1.call("feedBuffer", inputs1);
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect(feeder0, 0, expression, 0);
+        topology.connect(feeder1, 0, expression, 1);
+        topology.connect(expression, 0, collector, 0);
+
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive(0.05));
+    }
+
+    GPUTests::testBufferChunk(
+        GPUTests::stdVectorToBufferChunk(expectedOutputs),
+        collector.call<Pothos::BufferChunk>("getBuffer"));
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_expression_invalid)
+{
+    GPUTests::setupTestEnv();
+
+    const std::vector<std::string> invalidExpressions =
+    {
+        "",
+        "x +",
+        "(x",
+        "x)",
+        "foo(x)",
+        "sin(x, x)",
+        "hypot(x)",
+        "x1",
+        "x $ 2",
+    };
+
+    for(const auto& invalidExpression: invalidExpressions)
+    {
+        std::cout << "Testing invalid expression \"" << invalidExpression << "\"" << std::endl;
+
+        POTHOS_TEST_THROWS(
+            Pothos::BlockRegistry::make(
+                ExpressionBlockPath,
+                "Auto",
+                "float64",
+                1,
+                invalidExpression),
+            Pothos::ProxyExceptionMessage);
+    }
+}
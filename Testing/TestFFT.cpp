@@ -1,4 +1,4 @@
-// Copyright (c) 2019-2021 Nicholas Corgan
+// Copyright (c) 2019-2021,2023 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include "TestUtility.hpp"
@@ -8,9 +8,12 @@
 #include <Pothos/Plugin.hpp>
 #include <Pothos/Proxy.hpp>
 
+#include <arrayfire.h>
+
 #include <complex>
 #include <iostream>
 #include <string>
+#include <vector>
 
 //
 // Parameters
@@ -184,3 +187,148 @@ POTHOS_TEST_BLOCK("/gpu/tests", test_fft)
     testFFT<std::complex<float>>();
     testFFT<std::complex<double>>();
 }
+
+// Many frames queued at once should come out the same as one at a time,
+// regardless of how they're split into batches.
+POTHOS_TEST_BLOCK("/gpu/tests", test_fft_batched)
+{
+    using T = std::complex<double>;
+    constexpr size_t numFrames = 10;
+    constexpr size_t maxFramesPerCall = 3;
+
+    const auto testParams = getFFTTestParams<T, T>();
+    const Pothos::DType dtype(typeid(T));
+
+    std::vector<T> inputs;
+    std::vector<T> outputs;
+    for(size_t frame = 0; frame < numFrames; ++frame)
+    {
+        inputs.insert(inputs.end(), testParams.inputs.begin(), testParams.inputs.end());
+        outputs.insert(outputs.end(), testParams.outputs.begin(), testParams.outputs.end());
+    }
+
+    auto feeder = Pothos::BlockRegistry::make(
+                      "/blocks/feeder_source",
+                      dtype);
+    auto fftBlock = Pothos::BlockRegistry::make(
+                        "/gpu/signal/fft",
+                        "Auto",
+                        dtype,
+                        dtype,
+                        testParams.inputs.size(),
+                        1.0,
+                        false);
+    auto collector = Pothos::BlockRegistry::make(
+                         "/blocks/collector_sink",
+                         dtype);
+
+    fftBlock.call("setMaxFramesPerCall", maxFramesPerCall);
+    POTHOS_TEST_EQUAL(maxFramesPerCall, fftBlock.call<size_t>("maxFramesPerCall"));
+
+    feeder.call(
+        "feedBuffer",
+        GPUTests::stdVectorToBufferChunk(inputs));
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect(feeder, 0, fftBlock, 0);
+        topology.connect(fftBlock, 0, collector, 0);
+        topology.commit();
+
+        POTHOS_TEST_TRUE(topology.waitInactive(0.01));
+    }
+
+    GPUTests::testBufferChunk(
+        collector.call("getBuffer"),
+        GPUTests::stdVectorToBufferChunk(outputs));
+}
+
+static void setFFTPlanCacheSize(size_t cacheSize)
+{
+    auto plugin = Pothos::PluginRegistry::get("/gpu/fft/set_plan_cache_size");
+    plugin.getObject().extract<Pothos::Callable>().callVoid(cacheSize);
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_fft_plan_cache_size)
+{
+    const auto originalCacheSize = GPUTests::getAndCallPlugin<size_t>("/gpu/fft/plan_cache_size");
+
+    setFFTPlanCacheSize(20);
+    POTHOS_TEST_EQUAL(20, GPUTests::getAndCallPlugin<size_t>("/gpu/fft/plan_cache_size"));
+
+    POTHOS_TEST_THROWS(
+        setFFTPlanCacheSize(0),
+        Pothos::Exception);
+
+    setFFTPlanCacheSize(originalCacheSize);
+    POTHOS_TEST_EQUAL(originalCacheSize, GPUTests::getAndCallPlugin<size_t>("/gpu/fft/plan_cache_size"));
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_fft_plan_cache_reservations)
+{
+    using T = std::complex<double>;
+    constexpr size_t numBins = 64;
+    constexpr size_t numBlocks = 2;
+
+    // Batch sizes 1, 2, 4, and 8, so four plans per block
+    constexpr size_t maxFramesPerCall = 8;
+    constexpr size_t numPlansPerBlock = 4;
+
+    const Pothos::DType dtype(typeid(T));
+
+    const auto originalNumReserved = GPUTests::getAndCallPlugin<size_t>("/gpu/fft/num_reserved_plan_cache_entries");
+    const auto originalCacheSize = GPUTests::getAndCallPlugin<size_t>("/gpu/fft/plan_cache_size");
+
+    std::vector<Pothos::Proxy> feeders;
+    std::vector<Pothos::Proxy> fftBlocks;
+    std::vector<Pothos::Proxy> collectors;
+    for(size_t blockIndex = 0; blockIndex < numBlocks; ++blockIndex)
+    {
+        feeders.emplace_back(Pothos::BlockRegistry::make("/blocks/feeder_source", dtype));
+        fftBlocks.emplace_back(Pothos::BlockRegistry::make(
+                                   "/gpu/signal/fft",
+                                   "Auto",
+                                   dtype,
+                                   dtype,
+                                   numBins,
+                                   1.0,
+                                   false));
+        collectors.emplace_back(Pothos::BlockRegistry::make("/blocks/collector_sink", dtype));
+
+        fftBlocks.back().call("setMaxFramesPerCall", maxFramesPerCall);
+    }
+
+    {
+        Pothos::Topology topology;
+
+        for(size_t blockIndex = 0; blockIndex < numBlocks; ++blockIndex)
+        {
+            topology.connect(feeders[blockIndex], 0, fftBlocks[blockIndex], 0);
+            topology.connect(fftBlocks[blockIndex], 0, collectors[blockIndex], 0);
+        }
+        topology.commit();
+
+        // Each active block warms up and reserves a plan per batch size.
+        // The blocks' shapes are the same, so they share each plan.
+        POTHOS_TEST_EQUAL(
+            originalNumReserved + numPlansPerBlock,
+            GPUTests::getAndCallPlugin<size_t>("/gpu/fft/num_reserved_plan_cache_entries"));
+
+        // Resizing the caches switches to each device with reservations,
+        // but shouldn't leave this thread on a different one.
+        const auto backend = af::getActiveBackend();
+        const int device = af::getDevice();
+
+        setFFTPlanCacheSize(originalCacheSize + 1);
+        POTHOS_TEST_TRUE(backend == af::getActiveBackend());
+        POTHOS_TEST_EQUAL(device, af::getDevice());
+
+        setFFTPlanCacheSize(originalCacheSize);
+    }
+
+    // Released on deactivation
+    POTHOS_TEST_EQUAL(
+        originalNumReserved,
+        GPUTests::getAndCallPlugin<size_t>("/gpu/fft/num_reserved_plan_cache_entries"));
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "TestUtility.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_fft_convolve_streaming)
+{
+    const std::string type = "float64";
+
+    for(size_t numTaps: {1, 5, 300})
+    {
+        std::cout << "Taps: " << numTaps << std::endl;
+
+        std::vector<double> taps;
+        for(size_t tap = 0; tap < numTaps; ++tap)
+        {
+            taps.emplace_back(GPUTests::getSingleTestInput(type).convert<double>());
+        }
+
+        const auto inputs = GPUTests::getTestInputs(type);
+
+        auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+        auto convolve = Pothos::BlockRegistry::make("/gpu/signal/fftconvolve", "Auto", type);
+        auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", type);
+
+        POTHOS_TEST_EQUAL(0, convolve.call<size_t>("fftSize"));
+        convolve.call("setStreaming", true);
+        convolve.call("setTaps", taps);
+        POTHOS_TEST_TRUE(convolve.call<bool>("streaming"));
+        POTHOS_TEST_GE(convolve.call<size_t>("fftSize"), (2 * numTaps) - 1);
+
+        GPUTests::feedBufferInChunks(feeder, inputs, GPUTests::getStreamingChunkLengths());
+
+        {
+            Pothos::Topology topology;
+
+            topology.connect(feeder, 0, convolve, 0);
+            topology.connect(convolve, 0, collector, 0);
+
+            topology.commit();
+            POTHOS_TEST_TRUE(topology.waitInactive(0.05));
+        }
+
+        GPUTests::testBufferChunk(
+            GPUTests::getExpectedFIROutputs(inputs, taps),
+            collector.call<Pothos::BufferChunk>("getBuffer"));
+    }
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_fft_convolve_streaming_int)
+{
+    auto convolve = Pothos::BlockRegistry::make("/gpu/signal/fftconvolve", "Auto", "int32");
+
+    POTHOS_TEST_THROWS(
+        convolve.call("setStreaming", true),
+        Pothos::ProxyExceptionMessage);
+}
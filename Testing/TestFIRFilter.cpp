@@ -0,0 +1,93 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "TestUtility.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_fir_filter_streaming)
+{
+    const std::string type = "float64";
+
+    for(size_t numTaps: {1, 5, 129})
+    {
+        std::vector<double> taps;
+        for(size_t tap = 0; tap < numTaps; ++tap)
+        {
+            taps.emplace_back(GPUTests::getSingleTestInput(type).convert<double>());
+        }
+
+        const auto inputs = GPUTests::getTestInputs(type);
+        const auto expectedOutputs = GPUTests::getExpectedFIROutputs(inputs, taps);
+
+        // Force each engine for the same taps.
+        for(size_t overlapSaveThreshold: {numTaps+1, numTaps})
+        {
+            const bool isOverlapSave = (numTaps >= overlapSaveThreshold);
+            std::cout << "Taps: " << numTaps
+                      << ", engine: " << (isOverlapSave ? "overlap-save" : "af::fir")
+                      << std::endl;
+
+            auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+            auto fir = Pothos::BlockRegistry::make("/gpu/signal/fir_filter", "Auto", type);
+            auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", type);
+
+            fir.call("setOverlapSaveThreshold", overlapSaveThreshold);
+            fir.call("setTaps", taps);
+            POTHOS_TEST_EQUAL(overlapSaveThreshold, fir.call<size_t>("overlapSaveThreshold"));
+
+            GPUTests::feedBufferInChunks(feeder, inputs, GPUTests::getStreamingChunkLengths());
+
+            {
+                Pothos::Topology topology;
+
+                topology.connect(feeder, 0, fir, 0);
+                topology.connect(fir, 0, collector, 0);
+
+                topology.commit();
+                POTHOS_TEST_TRUE(topology.waitInactive(0.05));
+            }
+
+            GPUTests::testBufferChunk(
+                expectedOutputs,
+                collector.call<Pothos::BufferChunk>("getBuffer"));
+        }
+    }
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_fir_filter_overlap_save_calibration)
+{
+    const std::string type = "float64";
+
+    auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+    auto fir = Pothos::BlockRegistry::make("/gpu/signal/fir_filter", "Auto", type);
+    auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", type);
+
+    // PothosFlow sets the default, which should leave measuring enabled.
+    fir.call("setOverlapSaveThreshold", 0);
+
+    feeder.call("feedBuffer", GPUTests::getTestInputs(type));
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect(feeder, 0, fir, 0);
+        topology.connect(fir, 0, collector, 0);
+
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive(0.05));
+    }
+
+    // Measured on activation as a power of two, up to twice the largest
+    // tap count measured.
+    const auto threshold = fir.call<size_t>("overlapSaveThreshold");
+    POTHOS_TEST_GE(threshold, 8);
+    POTHOS_TEST_LE(threshold, 2048);
+    POTHOS_TEST_EQUAL(0, (threshold & (threshold - 1)));
+}
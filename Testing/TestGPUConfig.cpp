@@ -1,16 +1,22 @@
-// Copyright (c) 2019-2020 Nicholas Corgan
+// Copyright (c) 2019-2020,2023 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include "DeviceCache.hpp"
+#include "DeviceProfile.hpp"
 #include "TestUtility.hpp"
 #include "Utility.hpp"
 
 #include <Pothos/Framework.hpp>
 #include <Pothos/Object.hpp>
+#include <Pothos/Plugin.hpp>
 #include <Pothos/Testing.hpp>
 
+#include <nlohmann/json.hpp>
+
 #include <arrayfire.h>
 
+#include <algorithm>
+#include <string>
 #include <typeinfo>
 
 POTHOS_TEST_BLOCK("/gpu/tests", test_pothosgpu_config)
@@ -23,13 +29,23 @@ POTHOS_TEST_BLOCK("/gpu/tests", test_pothosgpu_config)
     const auto& deviceCache = getDeviceCache();
     POTHOS_TEST_FALSE(deviceCache.empty());
 
+    // "Auto" resolves to whichever device was fastest in the stored profile.
     POTHOS_TEST_EQUAL(
-        deviceCache[0].afBackendEnum,
-        abs.call<af::Backend>("backend"));
-    POTHOS_TEST_EQUAL(
-        deviceCache[0].name,
+        getAutoDevice(DeviceOpClass::Elementwise),
         abs.call<std::string>("device"));
 
+    auto autoEntryIter = std::find_if(
+                             deviceCache.begin(),
+                             deviceCache.end(),
+                             [&abs](const DeviceCacheEntry& entry)
+                             {
+                                 return (entry.name == abs.call<std::string>("device"));
+                             });
+    POTHOS_TEST_TRUE(deviceCache.end() != autoEntryIter);
+    POTHOS_TEST_EQUAL(
+        autoEntryIter->afBackendEnum,
+        abs.call<af::Backend>("backend"));
+
     for(const auto& entry: deviceCache)
     {
         abs = Pothos::BlockRegistry::make(
@@ -45,3 +61,33 @@ POTHOS_TEST_BLOCK("/gpu/tests", test_pothosgpu_config)
             abs.call<std::string>("device"));
     }
 }
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_auto_device_selections)
+{
+    const auto& deviceCache = getDeviceCache();
+    POTHOS_TEST_FALSE(deviceCache.empty());
+
+    // Benchmarking only happens when explicitly requested.
+    auto profilePlugin = Pothos::PluginRegistry::get("/gpu/profile_devices");
+    profilePlugin.getObject().extract<Pothos::Callable>().call();
+
+    auto plugin = Pothos::PluginRegistry::get("/devices/gpu/info");
+    auto getter = plugin.getObject().extract<Pothos::Callable>();
+    const auto info = nlohmann::json::parse(getter.call<std::string>());
+
+    const auto& selections = info["PothosGPU Auto Device Selection"];
+    for(auto opClass: {DeviceOpClass::Elementwise, DeviceOpClass::Transcendental, DeviceOpClass::FFT})
+    {
+        const auto device = selections[deviceOpClassToString(opClass)].get<std::string>();
+        POTHOS_TEST_EQUAL(
+            device,
+            getAutoDevice(opClass));
+        POTHOS_TEST_TRUE(deviceCache.end() != std::find_if(
+                                                  deviceCache.begin(),
+                                                  deviceCache.end(),
+                                                  [&device](const DeviceCacheEntry& entry)
+                                                  {
+                                                      return (entry.name == device);
+                                                  }));
+    }
+}
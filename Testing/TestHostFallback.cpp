@@ -0,0 +1,97 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "TestUtility.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+static Pothos::BufferChunk runBlock(
+    const Pothos::Proxy& block,
+    const std::string& type,
+    const Pothos::BufferChunk& inputs)
+{
+    auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+    auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", type);
+
+    feeder.call("feedBuffer", inputs);
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect(feeder, 0, block, 0);
+        topology.connect(block, 0, collector, 0);
+
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive(0.05));
+    }
+
+    return collector.call<Pothos::BufferChunk>("getBuffer");
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_host_fallback)
+{
+    static constexpr size_t LargeThreshold = 1 << 20;
+
+    for(const std::string& type: {"float32", "float64"})
+    {
+        for(const std::string& blockPath: {"/gpu/arith/abs", "/gpu/arith/sin", "/gpu/arith/exp"})
+        {
+            std::cout << "Testing " << blockPath << " (" << type << ")" << std::endl;
+
+            const auto inputs = GPUTests::getTestInputs(type);
+
+            // All chunks go through ArrayFire.
+            auto afBlock = Pothos::BlockRegistry::make(blockPath, "Auto", type);
+            afBlock.call("setHostFallbackThreshold", 0);
+            const auto afOutputs = runBlock(afBlock, type, inputs);
+            POTHOS_TEST_EQUAL(0, afBlock.call<size_t>("hostFallbackThreshold"));
+
+            // All chunks are processed on the host.
+            auto hostBlock = Pothos::BlockRegistry::make(blockPath, "Auto", type);
+            hostBlock.call("setHostFallbackThreshold", LargeThreshold);
+            const auto hostOutputs = runBlock(hostBlock, type, inputs);
+            POTHOS_TEST_EQUAL(LargeThreshold, hostBlock.call<size_t>("hostFallbackThreshold"));
+
+            GPUTests::testBufferChunk(afOutputs, hostOutputs);
+
+            // The threshold is measured on activation, but should never be
+            // above the largest size measured.
+            auto calibratedBlock = Pothos::BlockRegistry::make(blockPath, "Auto", type);
+            GPUTests::testBufferChunk(
+                afOutputs,
+                runBlock(calibratedBlock, type, inputs));
+            POTHOS_TEST_LE(calibratedBlock.call<size_t>("hostFallbackThreshold"), (1 << 16));
+
+            // Measured once per function, type, and device, so another
+            // block reuses the first measurement.
+            auto cachedBlock = Pothos::BlockRegistry::make(blockPath, "Auto", type);
+            runBlock(cachedBlock, type, inputs);
+            POTHOS_TEST_EQUAL(
+                calibratedBlock.call<size_t>("hostFallbackThreshold"),
+                cachedBlock.call<size_t>("hostFallbackThreshold"));
+        }
+    }
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_host_fallback_unsupported)
+{
+    // There is no host kernel for integral types, so the block shouldn't
+    // accept a threshold it would ignore.
+    const std::string type = "int32";
+    auto block = Pothos::BlockRegistry::make("/gpu/arith/abs", "Auto", type);
+
+    POTHOS_TEST_THROWS(
+        block.call("hostFallbackThreshold"),
+        Pothos::ProxyExceptionMessage);
+    POTHOS_TEST_THROWS(
+        block.call("setHostFallbackThreshold", 0),
+        Pothos::ProxyExceptionMessage);
+
+    runBlock(block, type, GPUTests::getTestInputs(type));
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "TestUtility.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Direct-form II transposed with zero initial state, as if the whole
+// stream was filtered at once.
+static Pothos::BufferChunk getExpectedOutputs(
+    const Pothos::BufferChunk& inputs,
+    const std::vector<double>& feedForwardCoeffs,
+    const std::vector<double>& feedbackCoeffs)
+{
+    Pothos::BufferChunk outputs(inputs.dtype, inputs.elements());
+
+    const size_t order = feedForwardCoeffs.size() - 1;
+    std::vector<double> delayLine(order + 1, 0.0);
+
+    const double* in = inputs.as<const double*>();
+    double* out = outputs.as<double*>();
+    for(size_t elem = 0; elem < inputs.elements(); ++elem)
+    {
+        out[elem] = (feedForwardCoeffs[0] * in[elem]) + delayLine[0];
+        for(size_t i = 0; i < order; ++i)
+        {
+            delayLine[i] = (feedForwardCoeffs[i+1] * in[elem])
+                         - (feedbackCoeffs[i+1] * out[elem])
+                         + delayLine[i+1];
+        }
+    }
+
+    return outputs;
+}
+
+static void testIIRFilterStreaming(
+    const Pothos::Proxy& iir,
+    const std::string& type,
+    size_t numChannels)
+{
+    // A narrow resonator, which rings long past any one chunk.
+    const std::vector<double> feedForwardCoeffs{0.01, 0.0, -0.01};
+    const std::vector<double> feedbackCoeffs{1.0, -1.8, 0.98};
+
+    // Chunk lengths shorter and longer than the filter order.
+    const std::vector<size_t> chunkLengths{100, 1, 37, 500, 2, 250};
+
+    iir.call("setFeedForwardCoeffs", feedForwardCoeffs);
+    iir.call("setFeedbackCoeffs", feedbackCoeffs);
+
+    std::vector<Pothos::BufferChunk> expectedOutputs;
+    std::vector<Pothos::Proxy> feeders;
+    std::vector<Pothos::Proxy> collectors;
+    for(size_t chan = 0; chan < numChannels; ++chan)
+    {
+        const auto inputs = GPUTests::getTestInputs(type);
+        expectedOutputs.emplace_back(getExpectedOutputs(inputs, feedForwardCoeffs, feedbackCoeffs));
+
+        feeders.emplace_back(Pothos::BlockRegistry::make("/blocks/feeder_source", type));
+        GPUTests::feedBufferInChunks(feeders.back(), inputs, chunkLengths);
+
+        collectors.emplace_back(Pothos::BlockRegistry::make("/blocks/collector_sink", type));
+    }
+
+    {
+        Pothos::Topology topology;
+
+        for(size_t chan = 0; chan < numChannels; ++chan)
+        {
+            topology.connect(feeders[chan], 0, iir, chan);
+            topology.connect(iir, chan, collectors[chan], 0);
+        }
+
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive(0.05));
+    }
+
+    for(size_t chan = 0; chan < numChannels; ++chan)
+    {
+        std::cout << "Testing channel " << chan << std::endl;
+
+        GPUTests::testBufferChunk(
+            expectedOutputs[chan],
+            collectors[chan].call<Pothos::BufferChunk>("getBuffer"));
+    }
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_iir_filter_streaming)
+{
+    const std::string type = "float64";
+
+    testIIRFilterStreaming(
+        Pothos::BlockRegistry::make("/gpu/signal/iir_filter", "Auto", type),
+        type,
+        1);
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_multichannel_iir_filter_streaming)
+{
+    const std::string type = "float64";
+    constexpr size_t numChannels = 3;
+
+    testIIRFilterStreaming(
+        Pothos::BlockRegistry::make("/gpu/signal/multichannel_iir_filter", "Auto", type, numChannels),
+        type,
+        numChannels);
+}
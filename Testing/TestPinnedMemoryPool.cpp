@@ -0,0 +1,76 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "DeviceCache.hpp"
+#include "SharedBufferAllocator.hpp"
+#include "TestUtility.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Plugin.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <arrayfire.h>
+
+#include <iostream>
+#include <string>
+
+template <typename... ArgsType>
+static void callPoolPlugin(const std::string& name, ArgsType&&... args)
+{
+    auto plugin = Pothos::PluginRegistry::get("/gpu/pinned_memory_pool/"+name);
+    plugin.getObject().extract<Pothos::Callable>().callVoid(args...);
+}
+
+static nlohmann::json getPoolStats()
+{
+    return nlohmann::json::parse(
+               GPUTests::getAndCallPlugin<std::string>("/gpu/pinned_memory_pool/stats"));
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_pinned_memory_pool)
+{
+    constexpr size_t AllocSize = 10000;
+
+    const auto originalCapacity = GPUTests::getAndCallPlugin<size_t>("/gpu/pinned_memory_pool/capacity");
+
+    for(const auto& backend: getAvailableBackends())
+    {
+        std::cout << "Backend: " << Pothos::Object(backend).convert<std::string>() << std::endl;
+
+        callPoolPlugin("clear");
+        callPoolPlugin("reset_stats");
+
+        // The first allocation has nothing to reuse.
+        size_t address = 0;
+        {
+            auto sharedBuffer = allocateSharedBuffer(backend, AllocSize);
+            POTHOS_TEST_EQUAL(AllocSize, sharedBuffer.getLength());
+            address = sharedBuffer.getAddress();
+        }
+        auto stats = getPoolStats();
+        POTHOS_TEST_EQUAL(0, stats["Hits"].get<size_t>());
+        POTHOS_TEST_EQUAL(1, stats["Misses"].get<size_t>());
+        POTHOS_TEST_GE(stats["Cached Bytes"].get<size_t>(), AllocSize);
+
+        // Anything in the same size class should reuse the freed region.
+        {
+            auto sharedBuffer = allocateSharedBuffer(backend, AllocSize-1);
+            POTHOS_TEST_EQUAL(address, sharedBuffer.getAddress());
+        }
+        stats = getPoolStats();
+        POTHOS_TEST_EQUAL(1, stats["Hits"].get<size_t>());
+        POTHOS_TEST_EQUAL(1, stats["Misses"].get<size_t>());
+
+        // With no capacity, nothing should be cached.
+        callPoolPlugin("set_capacity", size_t(0));
+        {
+            auto sharedBuffer = allocateSharedBuffer(backend, AllocSize);
+        }
+        stats = getPoolStats();
+        POTHOS_TEST_EQUAL(0, stats["Cached Bytes"].get<size_t>());
+
+        callPoolPlugin("set_capacity", originalCapacity);
+    }
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "TestUtility.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_pipelined_outputs)
+{
+    const std::string type = "float64";
+    constexpr size_t NumFeeds = 16;
+
+    for(size_t pipelineDepth = 0; pipelineDepth <= 4; ++pipelineDepth)
+    {
+        std::cout << "Testing pipeline depth " << pipelineDepth << "..." << std::endl;
+
+        auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+        auto abs = Pothos::BlockRegistry::make("/gpu/arith/abs", "Auto", type);
+        auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", type);
+
+        abs.call("setPipelineDepth", pipelineDepth);
+        POTHOS_TEST_EQUAL(pipelineDepth, abs.call<size_t>("pipelineDepth"));
+
+        // Outputs must come out in order, no matter how many are in flight.
+        std::vector<double> expectedOutputs;
+        for(size_t feed = 0; feed < NumFeeds; ++feed)
+        {
+            auto inputs = GPUTests::getTestInputs(type);
+            const auto* inputBuffer = inputs.as<const double*>();
+            for(size_t elem = 0; elem < inputs.elements(); ++elem)
+            {
+                expectedOutputs.emplace_back(std::abs(inputBuffer[elem]));
+            }
+
+            feeder.call("feedBuffer", inputs);
+        }
+
+        {
+            Pothos::Topology topology;
+
+            topology.connect(feeder, 0, abs, 0);
+            topology.connect(abs, 0, collector, 0);
+
+            topology.commit();
+            POTHOS_TEST_TRUE(topology.waitInactive(0.01));
+        }
+
+        GPUTests::testBufferChunk(
+            GPUTests::stdVectorToBufferChunk(expectedOutputs),
+            collector.call<Pothos::BufferChunk>("getBuffer"));
+    }
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_pipelining_requires_draining)
+{
+    const std::string type = "float64";
+
+    // This block doesn't drain in-flight outputs when it runs out of input,
+    // so it shouldn't let anything be put in flight.
+    auto max = Pothos::BlockRegistry::make("/gpu/algorithm/max", "Auto", type);
+    POTHOS_TEST_THROWS(
+        max.call("setPipelineDepth", 2),
+        Pothos::ProxyExceptionMessage);
+}
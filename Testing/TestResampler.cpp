@@ -0,0 +1,101 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "TestUtility.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Zero-stuff, filter, and keep every decimation'th output.
+static Pothos::BufferChunk getExpectedOutputs(
+    const Pothos::BufferChunk& inputs,
+    const std::vector<double>& taps,
+    size_t interpolation,
+    size_t decimation)
+{
+    Pothos::BufferChunk upsampled(inputs.dtype, inputs.elements() * interpolation);
+    std::memset(upsampled.as<void*>(), 0, upsampled.length);
+    for(size_t elem = 0; elem < inputs.elements(); ++elem)
+    {
+        upsampled.as<double*>()[elem * interpolation] = inputs.as<const double*>()[elem];
+    }
+
+    const auto filtered = GPUTests::getExpectedFIROutputs(upsampled, taps);
+
+    Pothos::BufferChunk outputs(inputs.dtype, (filtered.elements() + decimation - 1) / decimation);
+    for(size_t out = 0; out < outputs.elements(); ++out)
+    {
+        outputs.as<double*>()[out] = filtered.as<const double*>()[out * decimation];
+    }
+
+    return outputs;
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_resampler)
+{
+    const std::string type = "float64";
+
+    struct RateParams
+    {
+        size_t interpolation;
+        size_t decimation;
+    };
+    const std::vector<RateParams> allRateParams =
+    {
+        {1, 1},
+        {1, 8},
+        {4, 1},
+        {3, 8},
+        {8, 3}
+    };
+
+    std::vector<double> taps;
+    for(size_t tap = 0; tap < 23; ++tap)
+    {
+        taps.emplace_back(GPUTests::getSingleTestInput(type).convert<double>());
+    }
+
+    for(const auto& rateParams: allRateParams)
+    {
+        std::cout << "Interpolation: " << rateParams.interpolation
+                  << ", decimation: " << rateParams.decimation << std::endl;
+
+        const auto inputs = GPUTests::getTestInputs(type);
+
+        auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+        auto resampler = Pothos::BlockRegistry::make(
+                             "/gpu/signal/resampler",
+                             "Auto",
+                             type,
+                             rateParams.interpolation,
+                             rateParams.decimation);
+        auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", type);
+
+        POTHOS_TEST_EQUAL(rateParams.interpolation, resampler.call<size_t>("interpolation"));
+        POTHOS_TEST_EQUAL(rateParams.decimation, resampler.call<size_t>("decimation"));
+
+        resampler.call("setTaps", taps);
+
+        GPUTests::feedBufferInChunks(feeder, inputs, GPUTests::getStreamingChunkLengths());
+
+        {
+            Pothos::Topology topology;
+
+            topology.connect(feeder, 0, resampler, 0);
+            topology.connect(resampler, 0, collector, 0);
+
+            topology.commit();
+            POTHOS_TEST_TRUE(topology.waitInactive(0.05));
+        }
+
+        GPUTests::testBufferChunk(
+            getExpectedOutputs(inputs, taps, rateParams.interpolation, rateParams.decimation),
+            collector.call<Pothos::BufferChunk>("getBuffer"));
+    }
+}
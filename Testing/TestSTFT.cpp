@@ -0,0 +1,82 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "TestUtility.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static Pothos::BufferChunk getExpectedOutputs(
+    const std::vector<std::complex<double>>& spectra,
+    const std::string& outputMode)
+{
+    if("Complex" == outputMode) return GPUTests::stdVectorToBufferChunk(spectra);
+
+    std::vector<double> outputs;
+    for(const auto& value: spectra)
+    {
+        const double power = std::norm(value);
+        outputs.emplace_back(("dB" == outputMode) ? (10.0 * std::log10(power)) : power);
+    }
+
+    return GPUTests::stdVectorToBufferChunk(outputs);
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_stft)
+{
+    const std::string type = "float64";
+    constexpr size_t numBins = 128;
+    constexpr size_t hopSize = 32;
+
+    const auto inputs = GPUTests::getTestInputs(type);
+    const auto spectra = GPUTests::getExpectedSpectra(inputs, numBins, hopSize);
+
+    for(const std::string& outputMode: {"Complex", "MagnitudeSquared", "dB"})
+    {
+        std::cout << "Output mode: " << outputMode << std::endl;
+
+        const std::string outputType = ("Complex" == outputMode) ? "complex_float64" : type;
+
+        auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+        auto stft = Pothos::BlockRegistry::make(
+                        "/gpu/signal/stft",
+                        "Auto",
+                        type,
+                        numBins,
+                        hopSize,
+                        outputMode);
+        auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", outputType);
+
+        // Smaller than the number of frames, so multiple batches are needed.
+        stft.call("setMaxFramesPerCall", 4);
+        stft.call("setWindow", "Hann");
+        POTHOS_TEST_EQUAL("Hann", stft.call<std::string>("window"));
+        POTHOS_TEST_THROWS(
+            stft.call("setWindow", "NotAWindow"),
+            Pothos::ProxyExceptionMessage);
+        POTHOS_TEST_EQUAL("Hann", stft.call<std::string>("window"));
+
+        GPUTests::feedBufferInChunks(feeder, inputs, GPUTests::getStreamingChunkLengths());
+
+        {
+            Pothos::Topology topology;
+
+            topology.connect(feeder, 0, stft, 0);
+            topology.connect(stft, 0, collector, 0);
+
+            topology.commit();
+            POTHOS_TEST_TRUE(topology.waitInactive(0.05));
+        }
+
+        GPUTests::testBufferChunk(
+            getExpectedOutputs(spectra, outputMode),
+            collector.call<Pothos::BufferChunk>("getBuffer"));
+    }
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "TestUtility.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Object.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_sharded)
+{
+    const std::string type = "float64";
+
+    const std::vector<std::string> devices{"Auto", "Auto"};
+    const std::vector<std::vector<double>> weightsList{{}, {1.0, 3.0}};
+
+    // Small chunks so each shard is visited many times.
+    constexpr size_t chunkSize = 100;
+
+    auto inputs = GPUTests::getTestInputs(type);
+
+    Pothos::BufferChunk expectedOutputs(type, inputs.elements());
+    for(size_t elem = 0; elem < inputs.elements(); ++elem)
+    {
+        expectedOutputs.as<double*>()[elem] = std::abs(inputs.as<const double*>()[elem]);
+    }
+
+    for(const auto& weights: weightsList)
+    {
+        std::cout << "Weights: " << Pothos::Object(weights).toString() << std::endl;
+
+        auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+        auto sharded = Pothos::BlockRegistry::make(
+                           "/gpu/util/sharded",
+                           "/gpu/arith/abs",
+                           devices,
+                           weights,
+                           chunkSize,
+                           std::vector<Pothos::Object>{Pothos::Object(type)});
+        auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", type);
+
+        POTHOS_TEST_EQUAL(devices, sharded.call<std::vector<std::string>>("devices"));
+        POTHOS_TEST_EQUAL(
+            devices.size(),
+            sharded.call<std::vector<double>>("weights").size());
+
+        feeder.call("feedBuffer", inputs);
+
+        {
+            Pothos::Topology topology;
+
+            topology.connect(feeder, 0, sharded, 0);
+            topology.connect(sharded, 0, collector, 0);
+
+            topology.commit();
+            POTHOS_TEST_TRUE(topology.waitInactive(0.05));
+        }
+
+        GPUTests::testBufferChunk(
+            expectedOutputs,
+            collector.call<Pothos::BufferChunk>("getBuffer"));
+    }
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_sharded_invalid_params)
+{
+    const std::vector<Pothos::Object> blockArgs{Pothos::Object(std::string("float64"))};
+
+    POTHOS_TEST_THROWS(
+        Pothos::BlockRegistry::make(
+            "/gpu/util/sharded",
+            "/gpu/arith/abs",
+            std::vector<std::string>(),
+            std::vector<double>(),
+            size_t(100),
+            blockArgs),
+        Pothos::ProxyExceptionMessage);
+    POTHOS_TEST_THROWS(
+        Pothos::BlockRegistry::make(
+            "/gpu/util/sharded",
+            "/gpu/arith/abs",
+            std::vector<std::string>{"Auto", "Auto"},
+            std::vector<double>{1.0},
+            size_t(100),
+            blockArgs),
+        Pothos::ProxyExceptionMessage);
+    POTHOS_TEST_THROWS(
+        Pothos::BlockRegistry::make(
+            "/gpu/util/sharded",
+            "/gpu/arith/abs",
+            std::vector<std::string>{"Auto", "Auto"},
+            std::vector<double>{1.0, -1.0},
+            size_t(100),
+            blockArgs),
+        Pothos::ProxyExceptionMessage);
+}
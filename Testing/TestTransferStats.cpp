@@ -0,0 +1,78 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "TestUtility.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <arrayfire.h>
+
+#include <iostream>
+#include <string>
+
+static nlohmann::json getTransferStats(const Pothos::Proxy& block)
+{
+    return nlohmann::json::parse(block.call<std::string>("transferStats"));
+}
+
+static void testTransferStatsEmpty(const nlohmann::json& stats)
+{
+    POTHOS_TEST_EQUAL(0, stats["Host to Device"]["Bytes"].get<size_t>());
+    POTHOS_TEST_EQUAL(0, stats["Host to Device"]["Transfers"].get<size_t>());
+    POTHOS_TEST_EQUAL(0, stats["Device to Host"]["Bytes"].get<size_t>());
+    POTHOS_TEST_EQUAL(0, stats["Device to Host"]["Transfers"].get<size_t>());
+    POTHOS_TEST_EQUAL(0.0, stats["Compute Time (s)"].get<double>());
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_transfer_stats)
+{
+    const std::string type = "float32";
+
+    for(bool profilingEnabled: {false, true})
+    {
+        std::cout << "Profiling enabled: " << std::boolalpha << profilingEnabled << std::endl;
+
+        auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+        auto abs = Pothos::BlockRegistry::make("/gpu/arith/abs", "Auto", type);
+        auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", type);
+
+        abs.call("setProfilingEnabled", profilingEnabled);
+        POTHOS_TEST_EQUAL(profilingEnabled, abs.call<bool>("profilingEnabled"));
+
+        auto inputs = GPUTests::getTestInputs(type);
+        feeder.call("feedBuffer", inputs);
+
+        {
+            Pothos::Topology topology;
+
+            topology.connect(feeder, 0, abs, 0);
+            topology.connect(abs, 0, collector, 0);
+
+            topology.commit();
+            POTHOS_TEST_TRUE(topology.waitInactive(0.05));
+        }
+
+        auto stats = getTransferStats(abs);
+        POTHOS_TEST_EQUAL(profilingEnabled, stats["Profiling Enabled"].get<bool>());
+
+        if(profilingEnabled)
+        {
+            // The CPU backend wraps input buffers instead of uploading them.
+            if((abs.call<std::string>("backend") != "CPU") || (AF_API_VERSION < 37))
+            {
+                POTHOS_TEST_EQUAL(inputs.length, stats["Host to Device"]["Bytes"].get<size_t>());
+                POTHOS_TEST_GT(stats["Host to Device"]["Transfers"].get<size_t>(), 0);
+            }
+            POTHOS_TEST_EQUAL(inputs.length, stats["Device to Host"]["Bytes"].get<size_t>());
+            POTHOS_TEST_GT(stats["Device to Host"]["Transfers"].get<size_t>(), 0);
+        }
+        else testTransferStatsEmpty(stats);
+
+        abs.call("resetTransferStats");
+        testTransferStatsEmpty(getTransferStats(abs));
+    }
+}
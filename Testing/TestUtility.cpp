@@ -1,25 +1,29 @@
-// Copyright (c) 2020 Nicholas Corgan
+// Copyright (c) 2020,2023 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include "ArrayFireContext.hpp"
 #include "DeviceCache.hpp"
 #include "TestUtility.hpp"
 
 #include <Poco/Random.h>
 #include <Poco/Timestamp.h>
 
+#include <Pothos/Exception.hpp>
 #include <Pothos/Framework.hpp>
 #include <Pothos/Plugin.hpp>
 #include <Pothos/Proxy.hpp>
 #include <Pothos/Testing.hpp>
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace GPUTests
 {
 
 void setupTestEnv()
 {
-    af::setBackend(getAvailableBackends()[0]);
+    setThreadArrayFireBackend(getAvailableBackends()[0]);
 }
 
 template <typename T>
@@ -175,6 +179,107 @@ Pothos::BufferChunk getTestInputs(const std::string& type)
     return Pothos::Object(af::randu(TestInputLength, afDType)).convert<Pothos::BufferChunk>();
 }
 
+void feedBufferInChunks(
+    const Pothos::Proxy& feeder,
+    const Pothos::BufferChunk& bufferChunk,
+    const std::vector<size_t>& chunkLengths)
+{
+    const size_t elemSize = bufferChunk.dtype.size();
+
+    size_t elemsFed = 0;
+    for(size_t chunkIndex = 0; elemsFed < bufferChunk.elements(); ++chunkIndex)
+    {
+        const size_t chunkLength = std::min(
+                                       chunkLengths[chunkIndex % chunkLengths.size()],
+                                       bufferChunk.elements() - elemsFed);
+
+        Pothos::BufferChunk chunk(bufferChunk.dtype, chunkLength);
+        std::memcpy(
+            chunk.as<void*>(),
+            bufferChunk.as<const char*>() + (elemsFed * elemSize),
+            chunkLength * elemSize);
+        feeder.call("feedBuffer", chunk);
+
+        elemsFed += chunkLength;
+    }
+}
+
+const std::vector<size_t>& getStreamingChunkLengths()
+{
+    static const std::vector<size_t> StreamingChunkLengths{100, 37, 500, 3, 250};
+
+    return StreamingChunkLengths;
+}
+
+template <typename T>
+static Pothos::BufferChunk getExpectedFIROutputs(
+    const Pothos::BufferChunk& inputs,
+    const std::vector<double>& taps)
+{
+    Pothos::BufferChunk outputs(inputs.dtype, inputs.elements());
+
+    const T* in = inputs.as<const T*>();
+    T* out = outputs.as<T*>();
+    for(size_t elem = 0; elem < inputs.elements(); ++elem)
+    {
+        out[elem] = T(0);
+        for(size_t tap = 0; (tap < taps.size()) && (tap <= elem); ++tap)
+        {
+            out[elem] += taps[tap] * in[elem-tap];
+        }
+    }
+
+    return outputs;
+}
+
+Pothos::BufferChunk getExpectedFIROutputs(
+    const Pothos::BufferChunk& inputs,
+    const std::vector<double>& taps)
+{
+    if(inputs.dtype == Pothos::DType(typeid(double)))
+    {
+        return getExpectedFIROutputs<double>(inputs, taps);
+    }
+    else if(inputs.dtype == Pothos::DType(typeid(std::complex<double>)))
+    {
+        return getExpectedFIROutputs<std::complex<double>>(inputs, taps);
+    }
+
+    throw Pothos::InvalidArgumentException("Unsupported type", inputs.dtype.name());
+}
+
+std::vector<std::complex<double>> getExpectedSpectra(
+    const Pothos::BufferChunk& inputs,
+    size_t numBins,
+    size_t hopSize)
+{
+    if(inputs.dtype != Pothos::DType(typeid(double)))
+    {
+        throw Pothos::InvalidArgumentException("Unsupported type", inputs.dtype.name());
+    }
+
+    const double twoPi = 2.0 * std::acos(-1.0);
+    const double* in = inputs.as<const double*>();
+    const size_t numFrames = ((inputs.elements() - numBins) / hopSize) + 1;
+
+    std::vector<std::complex<double>> spectra;
+    for(size_t frame = 0; frame < numFrames; ++frame)
+    {
+        for(size_t bin = 0; bin < numBins; ++bin)
+        {
+            std::complex<double> sum(0.0, 0.0);
+            for(size_t n = 0; n < numBins; ++n)
+            {
+                const double window = 0.5 - (0.5 * std::cos(twoPi * n / numBins));
+                sum += (window * in[(frame * hopSize) + n]) * std::polar(1.0, -twoPi * bin * n / numBins);
+            }
+            spectra.emplace_back(sum);
+        }
+    }
+
+    return spectra;
+}
+
 Pothos::Object getRandomValue(const Pothos::BufferChunk& bufferChunk)
 {
     #define GET_RANDOM_VALUE_OF_TYPE(typeStr, cType) \
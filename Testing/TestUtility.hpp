@@ -1,4 +1,4 @@
-// Copyright (c) 2019-2020 Nicholas Corgan
+// Copyright (c) 2019-2020,2023 Nicholas Corgan
 // SPDX-License-Identifier: BSD-3-Clause
 
 #pragma once
@@ -181,6 +181,34 @@ Pothos::Object getRandomValue(const Pothos::BufferChunk& bufferChunk);
 
 Pothos::Object getSingleTestInput(const std::string& type);
 
+// Feeds the buffer as separate chunks, cycling through the given lengths,
+// to check that streaming blocks carry state between work() calls.
+void feedBufferInChunks(
+    const Pothos::Proxy& feeder,
+    const Pothos::BufferChunk& bufferChunk,
+    const std::vector<size_t>& chunkLengths);
+
+// Shorter and longer than the filters and frames in the streaming tests, so
+// history and frames span multiple chunks.
+const std::vector<size_t>& getStreamingChunkLengths();
+
+//
+// Reference DSP
+//
+
+// Direct-form convolution with zero initial state, as if the whole stream
+// was filtered at once. Inputs must be float64 or complex_float64.
+Pothos::BufferChunk getExpectedFIROutputs(
+    const Pothos::BufferChunk& inputs,
+    const std::vector<double>& taps);
+
+// Hann-windowed DFTs of every whole frame, as if the whole stream was
+// processed at once, with frames back to back. Inputs must be float64.
+std::vector<std::complex<double>> getExpectedSpectra(
+    const Pothos::BufferChunk& inputs,
+    size_t numBins,
+    size_t hopSize);
+
 //
 // Only test against blocks that exist
 //
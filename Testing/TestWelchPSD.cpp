@@ -0,0 +1,125 @@
+// Copyright (c) 2023 Nicholas Corgan
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "TestUtility.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <algorithm>
+#include <complex>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// |X|^2 of the Hann-windowed DFT of every whole frame, one frame per vector.
+static std::vector<std::vector<double>> getPowerSpectra(
+    const Pothos::BufferChunk& inputs,
+    size_t numBins,
+    size_t hopSize)
+{
+    const auto spectra = GPUTests::getExpectedSpectra(inputs, numBins, hopSize);
+
+    std::vector<std::vector<double>> powerSpectra;
+    for(size_t frameStart = 0; frameStart < spectra.size(); frameStart += numBins)
+    {
+        std::vector<double> powerSpectrum;
+        for(size_t bin = 0; bin < numBins; ++bin)
+        {
+            powerSpectrum.emplace_back(std::norm(spectra[frameStart + bin]));
+        }
+        powerSpectra.emplace_back(std::move(powerSpectrum));
+    }
+
+    return powerSpectra;
+}
+
+static Pothos::BufferChunk getExpectedOutputs(
+    const std::vector<std::vector<double>>& powerSpectra,
+    const std::string& averaging,
+    size_t numAverages,
+    double alpha)
+{
+    const size_t numBins = powerSpectra[0].size();
+
+    std::vector<double> outputs;
+    std::vector<double> accumulator;
+    for(size_t frame = 0; frame < powerSpectra.size(); ++frame)
+    {
+        const auto& powerSpectrum = powerSpectra[frame];
+        if(accumulator.empty())
+        {
+            accumulator = powerSpectrum;
+        }
+        else
+        {
+            for(size_t bin = 0; bin < numBins; ++bin)
+            {
+                if("Linear" == averaging)           accumulator[bin] += powerSpectrum[bin];
+                else if("MaxHold" == averaging)     accumulator[bin] = std::max(accumulator[bin], powerSpectrum[bin]);
+                else accumulator[bin] = (alpha * powerSpectrum[bin]) + ((1.0 - alpha) * accumulator[bin]);
+            }
+        }
+
+        if(0 == ((frame + 1) % numAverages))
+        {
+            for(size_t bin = 0; bin < numBins; ++bin)
+            {
+                outputs.emplace_back(("Linear" == averaging) ? (accumulator[bin] / numAverages) : accumulator[bin]);
+            }
+            if("Exponential" != averaging) accumulator.clear();
+        }
+    }
+
+    return GPUTests::stdVectorToBufferChunk(outputs);
+}
+
+POTHOS_TEST_BLOCK("/gpu/tests", test_welch_psd)
+{
+    const std::string type = "float64";
+    constexpr size_t numBins = 64;
+    constexpr size_t hopSize = 32;
+    constexpr size_t numAverages = 4;
+    constexpr double alpha = 0.25;
+
+    const auto inputs = GPUTests::getTestInputs(type);
+    const auto powerSpectra = getPowerSpectra(inputs, numBins, hopSize);
+
+    for(const std::string& averaging: {"Linear", "Exponential", "MaxHold"})
+    {
+        std::cout << "Averaging: " << averaging << std::endl;
+
+        auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", type);
+        auto psd = Pothos::BlockRegistry::make(
+                       "/gpu/signal/welch_psd",
+                       "Auto",
+                       type,
+                       numBins,
+                       hopSize);
+        auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", type);
+
+        psd.call("setAveraging", averaging);
+        psd.call("setNumAverages", numAverages);
+        psd.call("setAlpha", alpha);
+
+        // Not a multiple of numAverages, so averages span batches.
+        psd.call("setMaxFramesPerCall", 3);
+
+        GPUTests::feedBufferInChunks(feeder, inputs, GPUTests::getStreamingChunkLengths());
+
+        {
+            Pothos::Topology topology;
+
+            topology.connect(feeder, 0, psd, 0);
+            topology.connect(psd, 0, collector, 0);
+
+            topology.commit();
+            POTHOS_TEST_TRUE(topology.waitInactive(0.05));
+        }
+
+        GPUTests::testBufferChunk(
+            getExpectedOutputs(powerSpectra, averaging, numAverages, alpha),
+            collector.call<Pothos::BufferChunk>("getBuffer"));
+    }
+}